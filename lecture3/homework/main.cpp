@@ -3,9 +3,100 @@
 #include "opencv2/opencv.hpp"
 #include "tools/img_tools.hpp"
 #include "tools/logger.hpp"
+#include "tools/pipeline.hpp"
 #include "io/hikrobot/include/MvCameraControl.h"
 #include <fmt/core.h>
 
+//流水线中传递的数据
+struct Frame
+{
+    cv::Mat img;
+    int frame_count;
+};
+
+struct Detection
+{
+    Frame frame;
+    std::list<auto_aim::Armor> armors;
+};
+
+//绘制装甲板角点与信息, 无效的角点/索引跳过
+static void draw_armors(cv::Mat & img, const std::list<auto_aim::Armor> & armors, int frame_count)
+{
+    for (const auto& armor : armors) {
+        // 1. 处理装甲板角点：Point2f（浮点）→ Point（整数），并检查有效性
+        std::vector<cv::Point> int_points;  // 用于存储转换后的整数型角点
+        bool points_valid = true;
+
+        // 1.1 检查角点集是否为空
+        if (armor.points.empty()) {
+            tools::logger()->warn("Frame {}: Armor points is empty, skip drawing.", frame_count);
+            points_valid = false;
+        }
+        // 1.2 检查角点数量是否为4（装甲板是四边形，必须4个角点）
+        else if (armor.points.size() != 4) {
+            tools::logger()->warn("Frame {}: Armor points count is {}, need 4, skip drawing.", 
+                                 frame_count, armor.points.size());
+            points_valid = false;
+        }
+        // 1.3 转换浮点角点→整数角点，并检查坐标是否在图像范围内
+        else {
+            for (const auto& float_p : armor.points) {
+                // 检查坐标是否超出图像边界（避免无效坐标导致绘图错误）
+                if (float_p.x < 0 || float_p.x >= img.cols || 
+                    float_p.y < 0 || float_p.y >= img.rows) {
+                    tools::logger()->warn("Frame {}: Invalid point ({:.1f}, {:.1f}) (out of image bounds), skip drawing.", 
+                                         frame_count, float_p.x, float_p.y);
+                    points_valid = false;
+                    int_points.clear();  // 清空无效的点集
+                    break;
+                }
+                // 用cvRound()四舍五入转换（比直接截断更精准，避免坐标偏移）
+                int_points.emplace_back(cvRound(float_p.x), cvRound(float_p.y));
+            }
+        }
+
+        // 2. 绘制装甲板矩形（仅当角点有效时执行）
+        if (points_valid) {
+            cv::polylines(img, int_points, true, cv::Scalar(0, 0, 255), 2); 
+        }
+        // 角点无效则跳过当前装甲板的后续绘制
+        else {
+            continue;
+        }
+
+        // 3. 绘制装甲板信息（颜色+代号），先检查索引是否合法（避免数组越界崩溃）
+        bool info_valid = true;
+        std::string armor_color_str, armor_name_str;
+
+        // 3.1 检查color索引是否在COLORS范围内（避免越界访问）
+        if (armor.color < 0 || armor.color >= static_cast<int>(auto_aim::COLORS.size())) {
+            tools::logger()->warn("Frame {}: Invalid armor color ({}) (out of COLORS range), skip text drawing.", 
+                                 frame_count, armor.color);
+            info_valid = false;
+        }
+        else {
+            armor_color_str = auto_aim::COLORS[armor.color];
+        }
+
+        // 3.2 检查name索引是否在ARMOR_NAMES范围内（避免越界访问）
+        if (armor.name < 0 || armor.name >= static_cast<int>(auto_aim::ARMOR_NAMES.size())) {
+            tools::logger()->warn("Frame {}: Invalid armor name ({}) (out of ARMOR_NAMES range), skip text drawing.", 
+                                 frame_count, armor.name);
+            info_valid = false;
+        }
+        else {
+            armor_name_str = auto_aim::ARMOR_NAMES[armor.name];
+        }
+
+        // 3.3 仅当信息合法时，绘制文本
+        if (info_valid) {
+            std::string info = fmt::format("{} {}", armor_color_str, armor_name_str);
+            // 注意：armor.center是Point2f，若tools::draw_text要求Point，需同样转换（此处假设支持Point2f，若报错可加cvRound）
+            tools::draw_text(img, info, armor.center, cv::Scalar(0, 0, 255), 0.8, 2);
+        }
+    }
+}
 
 int main()
 {
@@ -66,16 +157,20 @@ int main()
     auto_aim::YOLO yolo("/home/rm/Desktop/sp_vision_tutorial_26_jiuh/lecture3/homework/configs/yolo.yaml");
     tools::logger()->info("YOLO model initialized successfully.");
 
-    //读取图像+装甲板
+    //取图 -> 识别 -> 显示, 各阶段各占一个线程
+    tools::Pipeline pipeline;
     int frame_count = 0;
-    while (true) {
+
+    //取图只保留最新一帧, 识别跟不上时丢弃旧帧
+    //取图有100ms时限, 超时后检查是否已停止, 保证按q后流水线能退出
+    auto frames = pipeline.source("camera", [&]() -> std::optional<Frame> {
+        Frame frame{cv::Mat(), frame_count++};
         MV_FRAME_OUT raw_frame;
-        ret = MV_CC_GetImageBuffer(camera_handle, &raw_frame, 100);
-        if (ret != MV_OK) {
+        while (MV_CC_GetImageBuffer(camera_handle, &raw_frame, 100) != MV_OK) {
+            if (pipeline.stopping()) return std::nullopt;
             tools::logger()->warn("Failed to get image buffer, retrying...");
-            continue;
         }
-        cv::Mat img;
+        cv::Mat & img = frame.img;
         try {
             MV_CC_PIXEL_CONVERT_PARAM cvt_param;
             cvt_param.nWidth = raw_frame.stFrameInfo.nWidth;
@@ -87,7 +182,7 @@ int main()
             img.create(cv::Size(raw_frame.stFrameInfo.nWidth, raw_frame.stFrameInfo.nHeight), CV_8UC3);
             cvt_param.pDstBuffer = img.data;
             cvt_param.nDstBufferSize = img.total() * img.elemSize();
-            ret = MV_CC_ConvertPixelType(camera_handle, &cvt_param);
+            int ret = MV_CC_ConvertPixelType(camera_handle, &cvt_param);
             if (ret != MV_OK) {
                 tools::logger()->warn("Pixel conversion failed, using fallback.");
                 img = cv::Mat(cv::Size(raw_frame.stFrameInfo.nWidth, raw_frame.stFrameInfo.nHeight), 
@@ -103,93 +198,23 @@ int main()
         } catch (const std::exception& e) {
             tools::logger()->error("Image conversion error: {}", e.what());
             MV_CC_FreeImageBuffer(camera_handle, &raw_frame);
-            continue;
+            return frame;
         }
-
-
-
-
-
         MV_CC_FreeImageBuffer(camera_handle, &raw_frame);
-
-        //装甲板识别模型
-        auto armors = yolo.detect(img, frame_count);
-        frame_count++;
-
-        cv::Mat display_img = img.clone();
-        for (const auto& armor : armors) {
-            // 1. 处理装甲板角点：Point2f（浮点）→ Point（整数），并检查有效性
-            std::vector<cv::Point> int_points;  // 用于存储转换后的整数型角点
-            bool points_valid = true;
-
-            // 1.1 检查角点集是否为空
-            if (armor.points.empty()) {
-                tools::logger()->warn("Frame {}: Armor points is empty, skip drawing.", frame_count);
-                points_valid = false;
-            }
-            // 1.2 检查角点数量是否为4（装甲板是四边形，必须4个角点）
-            else if (armor.points.size() != 4) {
-                tools::logger()->warn("Frame {}: Armor points count is {}, need 4, skip drawing.", 
-                                     frame_count, armor.points.size());
-                points_valid = false;
-            }
-            // 1.3 转换浮点角点→整数角点，并检查坐标是否在图像范围内
-            else {
-                for (const auto& float_p : armor.points) {
-                    // 检查坐标是否超出图像边界（避免无效坐标导致绘图错误）
-                    if (float_p.x < 0 || float_p.x >= display_img.cols || 
-                        float_p.y < 0 || float_p.y >= display_img.rows) {
-                        tools::logger()->warn("Frame {}: Invalid point ({:.1f}, {:.1f}) (out of image bounds), skip drawing.", 
-                                             frame_count, float_p.x, float_p.y);
-                        points_valid = false;
-                        int_points.clear();  // 清空无效的点集
-                        break;
-                    }
-                    // 用cvRound()四舍五入转换（比直接截断更精准，避免坐标偏移）
-                    int_points.emplace_back(cvRound(float_p.x), cvRound(float_p.y));
-                }
-            }
-
-            // 2. 绘制装甲板矩形（仅当角点有效时执行）
-            if (points_valid) {
-                cv::polylines(display_img, int_points, true, cv::Scalar(0, 0, 255), 2); 
-            }
-            // 角点无效则跳过当前装甲板的后续绘制
-            else {
-                continue;
-            }
-
-            // 3. 绘制装甲板信息（颜色+代号），先检查索引是否合法（避免数组越界崩溃）
-            bool info_valid = true;
-            std::string armor_color_str, armor_name_str;
-
-            // 3.1 检查color索引是否在COLORS范围内（避免越界访问）
-            if (armor.color < 0 || armor.color >= static_cast<int>(auto_aim::COLORS.size())) {
-                tools::logger()->warn("Frame {}: Invalid armor color ({}) (out of COLORS range), skip text drawing.", 
-                                     frame_count, armor.color);
-                info_valid = false;
-            }
-            else {
-                armor_color_str = auto_aim::COLORS[armor.color];
-            }
-
-            // 3.2 检查name索引是否在ARMOR_NAMES范围内（避免越界访问）
-            if (armor.name < 0 || armor.name >= static_cast<int>(auto_aim::ARMOR_NAMES.size())) {
-                tools::logger()->warn("Frame {}: Invalid armor name ({}) (out of ARMOR_NAMES range), skip text drawing.", 
-                                     frame_count, armor.name);
-                info_valid = false;
-            }
-            else {
-                armor_name_str = auto_aim::ARMOR_NAMES[armor.name];
-            }
-
-            // 3.3 仅当信息合法时，绘制文本
-            if (info_valid) {
-                std::string info = fmt::format("{} {}", armor_color_str, armor_name_str);
-                // 注意：armor.center是Point2f，若tools::draw_text要求Point，需同样转换（此处假设支持Point2f，若报错可加cvRound）
-                tools::draw_text(display_img, info, armor.center, cv::Scalar(0, 0, 255), 0.8, 2);
-            }
-        }
+        return frame;
+    }, 1, tools::Backpressure::drop_oldest);
+
+    //装甲板识别模型
+    auto detections = pipeline.stage("detect", frames, [&](Frame && frame) {
+        std::list<auto_aim::Armor> armors;
+        if (!frame.img.empty()) armors = yolo.detect(frame.img, frame.frame_count);
+        return Detection{std::move(frame), std::move(armors)};
+    });
+
+    pipeline.sink("display", detections, [&](Detection && detection) {
+        if (detection.frame.img.empty()) return;
+        cv::Mat display_img = detection.frame.img.clone();
+        draw_armors(display_img, detection.armors, detection.frame.frame_count);
         cv::resize(display_img, display_img, cv::Size(640, 480));
         cv::imshow("Armor Detection", display_img);
 
@@ -197,9 +222,13 @@ int main()
         char key = cv::waitKey(1);
         if (key == 'q') {
             tools::logger()->info("Exit command received.");
-            break;
+            pipeline.stop();
         }
-    }
+    });
+
+    pipeline.run();
+    pipeline.report();
+
     MV_CC_StopGrabbing(camera_handle);
     MV_CC_CloseDevice(camera_handle);
     MV_CC_DestroyHandle(camera_handle);
@@ -208,7 +237,3 @@ int main()
 
     return 0;
 }
-
-
-
-
@@ -0,0 +1,161 @@
+#include <fmt/core.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tasks/yolo.hpp"
+#include "tools/logger.hpp"
+
+// 用法: ./model_benchmark 视频 [--config configs/yolo.yaml] [--models a.xml,b.xml] [--sizes 640,480]
+//                         [--precisions default,f16] [--streams 1,2] [--threads 0,4] [--frames 300]
+// 在基础配置上覆盖模型路径与推理参数, 对所有组合逐一测试, 第一个组合作为一致性比较的基准
+namespace
+{
+std::vector<std::string> split(const std::string & text)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(text);
+  std::string item;
+  while (std::getline(ss, item, ',')) items.push_back(item);
+  return items;
+}
+
+// 按中心距离把结果与基准中的装甲板配对, 统计数量一致率与配对角点的平均偏差
+struct Agreement
+{
+  int frames = 0, same_count = 0, matched = 0, same_name = 0;
+  double point_error_sum = 0;
+
+  void add(const std::list<auto_aim::Armor> & reference, const std::list<auto_aim::Armor> & result)
+  {
+    frames++;
+    if (reference.size() == result.size()) same_count++;
+
+    for (const auto & armor : reference) {
+      auto best = result.end();
+      double best_distance = 20;  // 像素, 超过视为漏检
+      for (auto it = result.begin(); it != result.end(); ++it) {
+        auto distance = cv::norm(it->center - armor.center);
+        if (distance < best_distance) best_distance = distance, best = it;
+      }
+      if (best == result.end()) continue;
+
+      matched++;
+      if (best->name == armor.name) same_name++;
+      double error = 0;
+      for (size_t i = 0; i < armor.points.size() && i < best->points.size(); i++)
+        error += cv::norm(armor.points[i] - best->points[i]);
+      point_error_sum += error / std::max<size_t>(1, armor.points.size());
+    }
+  }
+};
+
+}  // namespace
+
+int main(int argc, char * argv[])
+{
+  if (argc < 2) {
+    fmt::print(stderr, "usage: {} video [--config ...] [--models ...] [--sizes ...]\n", argv[0]);
+    return -1;
+  }
+
+  std::string video_path = argv[1], config_path = "configs/yolo.yaml";
+  std::vector<std::string> models, sizes = {"640"}, precisions = {"default"}, streams = {"0"},
+                                   threads = {"0"};
+  int max_frames = 300, warmup = 20;
+  for (int i = 2; i + 1 < argc; i += 2) {
+    std::string arg = argv[i], value = argv[i + 1];
+    if (arg == "--config") config_path = value;
+    else if (arg == "--models") models = split(value);
+    else if (arg == "--sizes") sizes = split(value);
+    else if (arg == "--precisions") precisions = split(value);
+    else if (arg == "--streams") streams = split(value);
+    else if (arg == "--threads") threads = split(value);
+    else if (arg == "--frames") max_frames = std::stoi(value);
+    else if (arg == "--warmup") warmup = std::stoi(value);
+  }
+
+  auto base = YAML::LoadFile(config_path);
+  if (models.empty()) models = {base["yolov5_model_path"].as<std::string>()};
+  auto variant_path = (std::filesystem::temp_directory_path() / "yolo_benchmark.yaml").string();
+
+  // 预先解码到内存, 计时中不包含解码
+  std::vector<cv::Mat> frames;
+  cv::VideoCapture cap(video_path);
+  cv::Mat img;
+  while ((int)frames.size() < max_frames && cap.read(img)) frames.push_back(img.clone());
+  if (frames.empty()) {
+    tools::logger()->error("No frames read from {}", video_path);
+    return -1;
+  }
+  tools::logger()->info("Loaded {} frames from {}", frames.size(), video_path);
+
+  std::vector<std::list<auto_aim::Armor>> reference;
+  fmt::print(
+    "{:<36} {:>5} {:>7} {:>3} {:>3} {:>8} {:>8} {:>8} {:>8} {:>7} {:>7} {:>7} {:>7}\n", "model",
+    "size", "prec", "str", "thr", "p50/ms", "p90/ms", "p99/ms", "max/ms", "fps", "count",
+    "name", "pt/px");
+
+  for (const auto & model : models)
+    for (const auto & size : sizes)
+      for (const auto & precision : precisions)
+        for (const auto & stream : streams)
+          for (const auto & thread : threads) {
+            // 写出覆盖了推理参数的临时配置, 由 YOLO 按正常流程读取
+            auto variant = YAML::Clone(base);
+            variant["yolov5_model_path"] = model;
+            variant["input_size"] = std::stoi(size);
+            if (precision != "default") variant["inference_precision"] = precision;
+            if (stream != "0") variant["num_streams"] = std::stoi(stream);
+            if (thread != "0") variant["inference_threads"] = std::stoi(thread);
+            std::ofstream(variant_path) << variant;
+
+            std::unique_ptr<auto_aim::YOLO> yolo;
+            try {
+              yolo = std::make_unique<auto_aim::YOLO>(variant_path, false);
+            } catch (const std::exception & e) {
+              tools::logger()->warn("Skip {} {} {}: {}", model, size, precision, e.what());
+              continue;
+            }
+
+            for (int i = 0; i < warmup; i++) yolo->detect(frames[i % frames.size()]);
+
+            std::vector<double> costs_ms;
+            std::vector<std::list<auto_aim::Armor>> results;
+            auto begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < frames.size(); i++) {
+              auto start = std::chrono::steady_clock::now();
+              results.push_back(yolo->detect(frames[i], i));
+              auto end = std::chrono::steady_clock::now();
+              costs_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            }
+            auto total_s =
+              std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+            if (reference.empty()) reference = results;
+            Agreement agreement;
+            for (size_t i = 0; i < results.size(); i++) agreement.add(reference[i], results[i]);
+
+            std::sort(costs_ms.begin(), costs_ms.end());
+            auto percentile = [&](double p) {
+              return costs_ms[static_cast<size_t>(p * (costs_ms.size() - 1))];
+            };
+            auto matched = std::max(1, agreement.matched);
+            fmt::print(
+              "{:<36} {:>5} {:>7} {:>3} {:>3} {:>8.2f} {:>8.2f} {:>8.2f} {:>8.2f} {:>7.1f} "
+              "{:>6.1f}% {:>6.1f}% {:>7.2f}\n",
+              model.substr(model.size() > 36 ? model.size() - 36 : 0), size, precision, stream,
+              thread, percentile(0.5), percentile(0.9), percentile(0.99), costs_ms.back(),
+              frames.size() / total_s, 100.0 * agreement.same_count / agreement.frames,
+              100.0 * agreement.same_name / matched, agreement.point_error_sum / matched);
+          }
+
+  std::filesystem::remove(variant_path);
+  return 0;
+}
@@ -0,0 +1,215 @@
+#include "tracker.hpp"
+
+#include <yaml-cpp/yaml.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "tools/logger.hpp"
+#include "tools/math_tools.hpp"
+
+namespace auto_aim
+{
+namespace
+{
+using Vector9d = Tracker::Vector9d;
+using Matrix9d = Tracker::Matrix9d;
+
+Matrix9d jacobian_f(double dt)
+{
+  Matrix9d F = Matrix9d::Identity();
+  F(0, 1) = dt;
+  F(2, 3) = dt;
+  F(4, 5) = dt;
+  F(6, 7) = dt;
+  return F;
+}
+
+// Piecewise White Noise Model
+// https://github.com/rlabbe/Kalman-and-Bayesian-Filters-in-Python/blob/master/07-Kalman-Filter-Math.ipynb
+Matrix9d process_noise(double dt, double sigma_v, double sigma_w)
+{
+  auto v = sigma_v * sigma_v;  // 加速度方差
+  auto w = sigma_w * sigma_w;  // 角加速度方差
+  auto a = std::pow(dt, 4) / 4;
+  auto b = std::pow(dt, 3) / 2;
+  auto c = std::pow(dt, 2);
+
+  Matrix9d Q = Matrix9d::Zero();
+  for (int i : {0, 2, 4}) {
+    Q(i, i) = a * v;
+    Q(i, i + 1) = Q(i + 1, i) = b * v;
+    Q(i + 1, i + 1) = c * v;
+  }
+  Q(6, 6) = a * w;
+  Q(6, 7) = Q(7, 6) = b * w;
+  Q(7, 7) = c * w;
+  return Q;
+}
+
+double armor_yaw_of(const Vector9d & x, int id) { return tools::limit_rad(x[6] + id * M_PI / 2); }
+
+Eigen::Vector3d armor_xyz_of(const Vector9d & x, int id)
+{
+  auto yaw = armor_yaw_of(x, id);
+  auto r = x[8];
+  return {x[0] - r * std::cos(yaw), x[2] - r * std::sin(yaw), x[4]};
+}
+
+Eigen::Vector4d h(const Vector9d & x, int id)
+{
+  Eigen::Vector4d z;
+  z[0] = armor_yaw_of(x, id);
+  z.tail<3>() = tools::xyz2aed(armor_xyz_of(x, id));
+  return z;
+}
+
+Eigen::Matrix<double, 4, 9> jacobian_h(const Vector9d & x, int id)
+{
+  auto yaw = armor_yaw_of(x, id);
+  auto r = x[8];
+
+  // 状态量 -> [armor_yaw, armor_x, armor_y, armor_z]
+  // clang-format off
+  Eigen::Matrix<double, 4, 9> J_x_to_yaw_xyz;
+  J_x_to_yaw_xyz << 0, 0, 0, 0, 0, 0, 1,                 0, 0,
+                    1, 0, 0, 0, 0, 0, r * std::sin(yaw),  0, -std::cos(yaw),
+                    0, 0, 1, 0, 0, 0, -r * std::cos(yaw), 0, -std::sin(yaw),
+                    0, 0, 0, 0, 1, 0, 0,                  0, 0;
+  // clang-format on
+
+  Eigen::Matrix4d J_yaw_xyz_to_z = Eigen::Matrix4d::Zero();
+  J_yaw_xyz_to_z(0, 0) = 1;
+  J_yaw_xyz_to_z.bottomRightCorner<3, 3>() = tools::xyz2aed_jacobian(armor_xyz_of(x, id));
+
+  return J_yaw_xyz_to_z * J_x_to_yaw_xyz;
+}
+
+}  // namespace
+
+Tracker::Tracker(const std::string & config_path)
+: tracking_(false), name_(ArmorName::not_armor), armor_id_(0), last_armor_yaw_(0), nis_(0)
+{
+  auto yaml = YAML::LoadFile(config_path);
+
+  r0_ = yaml["r0"].as<double>();
+  sigma_v_ = yaml["sigma_v"].as<double>();
+  sigma_w_ = yaml["sigma_w"].as<double>();
+  jump_thresh_ = yaml["jump_thresh"].as<double>() / 57.3;
+  lost_timeout_ = yaml["lost_timeout"].as<double>();
+
+  auto P0_diag = yaml["P0_diag"].as<std::vector<double>>();
+  auto R_diag = yaml["R_diag"].as<std::vector<double>>();
+  if (P0_diag.size() != 9 || R_diag.size() != 4)
+    throw std::runtime_error("Tracker: P0_diag needs 9 values and R_diag needs 4!");
+  P0_diag_ = Eigen::Map<Vector9d>(P0_diag.data());
+  R_diag_ = Eigen::Map<Eigen::Vector4d>(R_diag.data());
+}
+
+void Tracker::track(const Armor & armor, std::chrono::steady_clock::time_point t)
+{
+  auto dt = std::chrono::duration<double>(t - last_t_).count();
+
+  if (!tracking_ || armor.name != name_ || dt <= 0 || dt > lost_timeout_) {
+    init(armor, t);
+    return;
+  }
+
+  last_t_ = t;
+  predict(dt);
+
+  // 装甲板跳变: 观测到的装甲板yaw突变, 说明换到了相邻的装甲板
+  auto armor_yaw = armor.ypr_in_world[0];
+  auto dyaw = tools::limit_rad(armor_yaw - last_armor_yaw_);
+  if (dyaw > jump_thresh_) {
+    armor_id_ = (armor_id_ + 1) % 4;
+    tools::logger()->debug("Jump right to {}", armor_id_);
+  } else if (dyaw < -jump_thresh_) {
+    armor_id_ = (armor_id_ + 3) % 4;
+    tools::logger()->debug("Jump left to {}", armor_id_);
+  }
+
+  update(armor_yaw, armor.xyz_in_world);
+  last_armor_yaw_ = armor_yaw;
+}
+
+std::optional<Eigen::Vector3d> Tracker::aim_point(std::chrono::steady_clock::time_point t) const
+{
+  if (!tracking_) return std::nullopt;
+
+  auto dt = std::chrono::duration<double>(t - last_t_).count();
+  if (dt > lost_timeout_) return std::nullopt;
+
+  Vector9d x = jacobian_f(dt) * ekf_.x;
+  x[6] = tools::limit_rad(x[6]);
+
+  // 选择法向最接近视线方向的装甲板
+  auto center_azim = std::atan2(x[2], x[0]);
+  int best_id = 0;
+  double min_error = 1e10;
+  for (int id = 0; id < 4; id++) {
+    auto error = std::abs(tools::limit_rad(armor_yaw_of(x, id) - center_azim));
+    if (error < min_error) {
+      min_error = error;
+      best_id = id;
+    }
+  }
+
+  return armor_xyz_of(x, best_id);
+}
+
+void Tracker::init(const Armor & armor, std::chrono::steady_clock::time_point t)
+{
+  auto armor_yaw = armor.ypr_in_world[0];
+  const auto & armor_xyz = armor.xyz_in_world;
+
+  // 新目标总是从0号装甲板开始编号
+  armor_id_ = 0;
+  Vector9d x0;
+  x0 << armor_xyz[0] + r0_ * std::cos(armor_yaw), 0, armor_xyz[1] + r0_ * std::sin(armor_yaw), 0,
+    armor_xyz[2], 0, armor_yaw, 0, r0_;
+
+  ekf_ = tools::ExtendedKalmanFilter<9>(x0, P0_diag_.asDiagonal());
+
+  tracking_ = true;
+  name_ = armor.name;
+  last_armor_yaw_ = armor_yaw;
+  last_t_ = t;
+  nis_ = 0;
+}
+
+void Tracker::predict(double dt)
+{
+  ekf_.predict(jacobian_f(dt), process_noise(dt, sigma_v_, sigma_w_), [dt](const Vector9d & x) {
+    Vector9d x_prior = jacobian_f(dt) * x;
+    x_prior[6] = tools::limit_rad(x_prior[6]);
+    return x_prior;
+  });
+}
+
+void Tracker::update(double armor_yaw, const Eigen::Vector3d & armor_xyz)
+{
+  Eigen::Vector4d z;
+  z[0] = armor_yaw;
+  z.tail<3>() = tools::xyz2aed(armor_xyz);
+
+  auto id = armor_id_;
+  Eigen::Matrix4d R = R_diag_.asDiagonal();
+
+  nis_ = ekf_.update(
+    z, jacobian_h(ekf_.x, id), R, [id](const Vector9d & x) { return h(x, id); },
+    [](const Eigen::Vector4d & a, const Eigen::Vector4d & b) -> Eigen::Vector4d {
+      Eigen::Vector4d c = a - b;
+      c[0] = tools::limit_rad(c[0]);
+      c[1] = tools::limit_rad(c[1]);
+      return c;
+    },
+    [](const Vector9d & a, const Vector9d & b) -> Vector9d {
+      Vector9d c = a + b;
+      c[6] = tools::limit_rad(c[6]);
+      return c;
+    });
+}
+
+}  // namespace auto_aim
@@ -0,0 +1,59 @@
+#ifndef AUTO_AIM__TRACKER_HPP
+#define AUTO_AIM__TRACKER_HPP
+
+#include <Eigen/Dense>
+#include <chrono>
+#include <optional>
+#include <string>
+
+#include "armor.hpp"
+#include "tools/extended_kalman_filter.hpp"
+
+namespace auto_aim
+{
+// 整车观测器, 参考 lecture5/aim/model.py 与 lecture5/aim/tracker.py
+// 状态量: [x, vx, y, vy, z, vz, yaw, w, r] (world系, 单位: m, rad)
+// 量测量: [armor_yaw, azimuth, elevation, distance]
+class Tracker
+{
+public:
+  using Vector9d = Eigen::Matrix<double, 9, 1>;
+  using Matrix9d = Eigen::Matrix<double, 9, 9>;
+
+  explicit Tracker(const std::string & config_path);
+
+  // 需要 armor.xyz_in_world 与 armor.ypr_in_world 已由解算器填好
+  void track(const Armor & armor, std::chrono::steady_clock::time_point t);
+
+  // 外推到t时刻, 返回此时最正对相机的装甲板位置 (world系, 单位: m)
+  std::optional<Eigen::Vector3d> aim_point(std::chrono::steady_clock::time_point t) const;
+
+  bool tracking() const { return tracking_; }
+  int armor_id() const { return armor_id_; }
+  double nis() const { return nis_; }
+  const Vector9d & state() const { return ekf_.x; }
+
+private:
+  double r0_;
+  Vector9d P0_diag_;
+  double sigma_v_, sigma_w_;
+  Eigen::Vector4d R_diag_;
+  double jump_thresh_;  // rad
+  double lost_timeout_;  // s
+
+  tools::ExtendedKalmanFilter<9> ekf_;
+  bool tracking_;
+  ArmorName name_;
+  int armor_id_;
+  double last_armor_yaw_;
+  double nis_;
+  std::chrono::steady_clock::time_point last_t_;
+
+  void init(const Armor & armor, std::chrono::steady_clock::time_point t);
+  void predict(double dt);
+  void update(double armor_yaw, const Eigen::Vector3d & armor_xyz);
+};
+
+}  // namespace auto_aim
+
+#endif  // AUTO_AIM__TRACKER_HPP
@@ -3,6 +3,7 @@
 #include <fmt/chrono.h>
 #include <yaml-cpp/yaml.h>
 
+#include <chrono>
 #include <filesystem>
 
 #include "tools/img_tools.hpp"
@@ -29,15 +30,35 @@ YOLOV5::YOLOV5(const std::string & config_path, bool debug)
   roi_ = cv::Rect(x, y, width, height);
   offset_ = cv::Point2f(x, y);
 
+  // 以下为可选项, 用于比较不同输入尺寸与推理参数, 缺省时与原配置一致
+  input_size_ = yaml["input_size"] ? yaml["input_size"].as<int>() : 640;
+  ov::AnyMap config{ov::hint::performance_mode(ov::hint::PerformanceMode::LATENCY)};
+  if (yaml["num_streams"]) config.emplace(ov::num_streams(yaml["num_streams"].as<int>()));
+  if (yaml["inference_threads"])
+    config.emplace(ov::inference_num_threads(yaml["inference_threads"].as<int>()));
+  if (yaml["inference_precision"]) {
+    auto precision = yaml["inference_precision"].as<std::string>();
+    if (precision == "f32")
+      config.emplace(ov::hint::inference_precision(ov::element::f32));
+    else if (precision == "f16")
+      config.emplace(ov::hint::inference_precision(ov::element::f16));
+    else if (precision == "bf16")
+      config.emplace(ov::hint::inference_precision(ov::element::bf16));
+    else
+      throw std::runtime_error("Unknown inference precision: " + precision);
+  }
+
   save_path_ = "imgs";
   std::filesystem::create_directory(save_path_);
+  auto begin = std::chrono::steady_clock::now();
   auto model = core_.read_model(model_path_);
+  if (yaml["input_size"]) model->reshape({1, 3, input_size_, input_size_});
   ov::preprocess::PrePostProcessor ppp(model);
   auto & input = ppp.input();
 
   input.tensor()
     .set_element_type(ov::element::u8)
-    .set_shape({1, 640, 640, 3})
+    .set_shape({1, input_size_, input_size_, 3})
     .set_layout("NHWC")
     .set_color_format(ov::preprocess::ColorFormat::BGR);
 
@@ -48,10 +69,33 @@ YOLOV5::YOLOV5(const std::string & config_path, bool debug)
     .convert_color(ov::preprocess::ColorFormat::RGB)
     .scale(255.0);
 
-  // TODO: ov::hint::performance_mode(ov::hint::PerformanceMode::LATENCY)
   model = ppp.build();
-  compiled_model_ = core_.compile_model(
-    model, device_, ov::hint::performance_mode(ov::hint::PerformanceMode::LATENCY));
+  auto read_end = std::chrono::steady_clock::now();
+
+  // 编译结果缓存在磁盘上, 重启后直接导入
+  // OpenVINO按模型(含上面的预处理)哈希、设备与编译参数区分缓存文件, 修改任一项都会重新编译
+  auto cache_dir = yaml["cache_dir"] ? yaml["cache_dir"].as<std::string>() : std::string();
+  if (!cache_dir.empty()) core_.set_property(ov::cache_dir(cache_dir));
+
+  // 编译后缓存目录中多出文件说明未命中缓存
+  auto cache_files = [&cache_dir] {
+    std::error_code ec;
+    if (cache_dir.empty() || !std::filesystem::is_directory(cache_dir, ec)) return 0;
+    int count = 0;
+    for (auto it = std::filesystem::directory_iterator(cache_dir, ec);
+         it != std::filesystem::directory_iterator(); it.increment(ec))
+      count++;
+    return count;
+  };
+  auto cached = cache_files();
+  compiled_model_ = core_.compile_model(model, device_, config);
+  auto compile_end = std::chrono::steady_clock::now();
+  auto start = cache_dir.empty() ? "no cache" : cache_files() > cached ? "cold start" : "warm start";
+
+  tools::logger()->info(
+    "YOLOV5 {}: read {:.0f} ms, compile {:.0f} ms ({})", model_path_,
+    std::chrono::duration<double, std::milli>(read_end - begin).count(),
+    std::chrono::duration<double, std::milli>(compile_end - read_end).count(), start);
 }
 
 std::list<Armor> YOLOV5::detect(const cv::Mat & raw_img, int frame_count)
@@ -74,17 +118,18 @@ std::list<Armor> YOLOV5::detect(const cv::Mat & raw_img, int frame_count)
     bgr_img = raw_img;
   }
 
-  auto x_scale = static_cast<double>(640) / bgr_img.rows;
-  auto y_scale = static_cast<double>(640) / bgr_img.cols;
+  auto x_scale = static_cast<double>(input_size_) / bgr_img.rows;
+  auto y_scale = static_cast<double>(input_size_) / bgr_img.cols;
   auto scale = std::min(x_scale, y_scale);
   auto h = static_cast<int>(bgr_img.rows * scale);
   auto w = static_cast<int>(bgr_img.cols * scale);
 
   // preproces
-  auto input = cv::Mat(640, 640, CV_8UC3, cv::Scalar(0, 0, 0));
+  auto input = cv::Mat(input_size_, input_size_, CV_8UC3, cv::Scalar(0, 0, 0));
   auto roi = cv::Rect(0, 0, w, h);
   cv::resize(bgr_img, input(roi), {w, h});
-  ov::Tensor input_tensor(ov::element::u8, {1, 640, 640, 3}, input.data);
+  ov::Tensor input_tensor(
+    ov::element::u8, {1, size_t(input_size_), size_t(input_size_), 3}, input.data);
 
   // infer
   auto infer_request = compiled_model_.create_infer_request();
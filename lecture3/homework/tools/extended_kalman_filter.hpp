@@ -0,0 +1,75 @@
+#ifndef TOOLS__EXTENDED_KALMAN_FILTER_HPP
+#define TOOLS__EXTENDED_KALMAN_FILTER_HPP
+
+#include <Eigen/Dense>
+
+namespace tools
+{
+// 状态维度在编译期确定, predict/update 全程使用定长矩阵, 不会发生堆分配
+// 参考 lecture5/utils/ekf.py
+template <int N_X>
+class ExtendedKalmanFilter
+{
+public:
+  using VectorX = Eigen::Matrix<double, N_X, 1>;
+  using MatrixXX = Eigen::Matrix<double, N_X, N_X>;
+
+  VectorX x;
+  MatrixXX P;
+
+  ExtendedKalmanFilter() : x(VectorX::Zero()), P(MatrixXX::Identity()) {}
+
+  ExtendedKalmanFilter(const VectorX & x0, const MatrixXX & P0) : x(x0), P(P0) {}
+
+  // F: 状态转移函数的雅可比矩阵, f(x) -> x
+  template <typename F_FUNC>
+  void predict(const MatrixXX & F, const MatrixXX & Q, F_FUNC && f)
+  {
+    x = f(x);
+    P = F * P * F.transpose() + Q;
+  }
+
+  void predict(const MatrixXX & F, const MatrixXX & Q)
+  {
+    predict(F, Q, [&F](const VectorX & x) -> VectorX { return F * x; });
+  }
+
+  // h(x) -> z, z_subtract(a, b) -> a - b, x_add(a, b) -> a + b
+  // 自定义减法/加法便于处理角度突变
+  // 返回NIS(归一化新息平方), 可用于检验量测是否可信
+  template <int N_Z, typename H_FUNC, typename Z_SUB, typename X_ADD>
+  double update(
+    const Eigen::Matrix<double, N_Z, 1> & z, const Eigen::Matrix<double, N_Z, N_X> & H,
+    const Eigen::Matrix<double, N_Z, N_Z> & R, H_FUNC && h, Z_SUB && z_subtract, X_ADD && x_add)
+  {
+    const Eigen::Matrix<double, N_Z, N_Z> S = H * P * H.transpose() + R;
+    const Eigen::Matrix<double, N_Z, N_Z> S_inv = S.inverse();
+    const Eigen::Matrix<double, N_X, N_Z> K = P * H.transpose() * S_inv;
+
+    const Eigen::Matrix<double, N_Z, 1> y = z_subtract(z, h(x));
+    x = x_add(x, K * y);
+
+    // Stable Compution of the Posterior Covariance
+    // https://github.com/rlabbe/Kalman-and-Bayesian-Filters-in-Python/blob/master/07-Kalman-Filter-Math.ipynb
+    const MatrixXX I_KH = MatrixXX::Identity() - K * H;
+    P = I_KH * P * I_KH.transpose() + K * R * K.transpose();
+
+    return y.transpose() * S_inv * y;
+  }
+
+  template <int N_Z, typename H_FUNC>
+  double update(
+    const Eigen::Matrix<double, N_Z, 1> & z, const Eigen::Matrix<double, N_Z, N_X> & H,
+    const Eigen::Matrix<double, N_Z, N_Z> & R, H_FUNC && h)
+  {
+    return update(
+      z, H, R, h,
+      [](const Eigen::Matrix<double, N_Z, 1> & a, const Eigen::Matrix<double, N_Z, 1> & b)
+        -> Eigen::Matrix<double, N_Z, 1> { return a - b; },
+      [](const VectorX & a, const VectorX & b) -> VectorX { return a + b; });
+  }
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__EXTENDED_KALMAN_FILTER_HPP
@@ -0,0 +1,40 @@
+#include "math_tools.hpp"
+
+#include <cmath>
+
+namespace tools
+{
+double limit_rad(double angle)
+{
+  while (angle > M_PI) angle -= 2 * M_PI;
+  while (angle <= -M_PI) angle += 2 * M_PI;
+  return angle;
+}
+
+Eigen::Vector3d xyz2aed(const Eigen::Vector3d & xyz)
+{
+  auto x = xyz[0], y = xyz[1], z = xyz[2];
+  auto azim = std::atan2(y, x);
+  auto elev = std::atan2(z, std::sqrt(x * x + y * y));
+  auto dist = std::sqrt(x * x + y * y + z * z);
+  return {azim, elev, dist};
+}
+
+Eigen::Matrix3d xyz2aed_jacobian(const Eigen::Vector3d & xyz)
+{
+  auto x = xyz[0], y = xyz[1], z = xyz[2];
+  auto a = x * x + y * y;
+  auto b = std::sqrt(a);
+  auto c = a + z * z;
+  auto d = std::sqrt(c);
+
+  // clang-format off
+  Eigen::Matrix3d J;
+  J << -y / a,             x / a,              0,
+       -x * z / (b * c),  -y * z / (b * c),    b / c,
+        x / d,             y / d,              z / d;
+  // clang-format on
+  return J;
+}
+
+}  // namespace tools
@@ -0,0 +1,19 @@
+#ifndef TOOLS__MATH_TOOLS_HPP
+#define TOOLS__MATH_TOOLS_HPP
+
+#include <Eigen/Dense>
+
+namespace tools
+{
+// 将角度限制在(-pi, pi]
+double limit_rad(double angle);
+
+// 直角坐标 -> 方位角、俯仰角、距离 (azimuth, elevation, distance)
+Eigen::Vector3d xyz2aed(const Eigen::Vector3d & xyz);
+
+// xyz2aed 的雅可比矩阵
+Eigen::Matrix3d xyz2aed_jacobian(const Eigen::Vector3d & xyz);
+
+}  // namespace tools
+
+#endif  // TOOLS__MATH_TOOLS_HPP
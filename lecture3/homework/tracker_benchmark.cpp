@@ -0,0 +1,72 @@
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "tasks/armor.hpp"
+#include "tasks/tracker.hpp"
+#include "tools/logger.hpp"
+#include "tools/math_tools.hpp"
+
+// 用一个匀速小陀螺的仿真目标测量 Tracker 每帧 track + aim_point 的耗时
+int main(int argc, char * argv[])
+{
+  auto config_path = argc > 1 ? argv[1] : "configs/tracker.yaml";
+  tools::logger()->set_level(spdlog::level::info);  // 跳变日志不计入耗时
+  auto_aim::Tracker tracker(config_path);
+
+  const int frames = 100000;
+  const double dt = 1.0 / 150;
+  const double r = 0.2, w = 6.0;
+  const Eigen::Vector3d center{3.0, 0.5, 0.1};
+
+  std::mt19937 rng(42);
+  std::normal_distribution<double> xyz_noise(0, 0.01), yaw_noise(0, 0.05);
+
+  auto_aim::Armor armor(1, 3, 0.9f, cv::Rect(), std::vector<cv::Point2f>(4));
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<double> costs_ns;
+  costs_ns.reserve(frames);
+
+  for (int i = 0; i < frames; i++) {
+    // 仿真: 选出正对相机的那块装甲板作为观测
+    auto yaw = tools::limit_rad(w * i * dt);
+    auto center_azim = std::atan2(center[1], center[0]);
+    auto armor_yaw = yaw;
+    for (int id = 0; id < 4; id++) {
+      auto candidate = tools::limit_rad(yaw + id * M_PI / 2);
+      if (std::abs(tools::limit_rad(candidate - center_azim)) < M_PI / 4) armor_yaw = candidate;
+    }
+    armor.ypr_in_world = {armor_yaw + yaw_noise(rng), 0, 0};
+    armor.xyz_in_world = center - r * Eigen::Vector3d{std::cos(armor_yaw), std::sin(armor_yaw), 0} +
+                         Eigen::Vector3d{xyz_noise(rng), xyz_noise(rng), xyz_noise(rng)};
+
+    auto t = t0 + std::chrono::nanoseconds(static_cast<int64_t>(i * dt * 1e9));
+
+    auto start = std::chrono::steady_clock::now();
+    tracker.track(armor, t);
+    auto aim_point = tracker.aim_point(t + std::chrono::milliseconds(50));
+    auto end = std::chrono::steady_clock::now();
+
+    if (!aim_point) return -1;
+    costs_ns.emplace_back(std::chrono::duration<double, std::nano>(end - start).count());
+  }
+
+  std::sort(costs_ns.begin(), costs_ns.end());
+  double sum = 0;
+  for (auto c : costs_ns) sum += c;
+
+  const auto & x = tracker.state();
+  fmt::print("frames: {}\n", frames);
+  fmt::print(
+    "track + aim_point per frame: mean {:.0f} ns, p50 {:.0f} ns, p99 {:.0f} ns, max {:.0f} ns\n",
+    sum / frames, costs_ns[frames / 2], costs_ns[frames * 99 / 100], costs_ns.back());
+  fmt::print(
+    "final state: x {:.3f} y {:.3f} z {:.3f} w {:.2f} r {:.3f} (truth: {:.3f} {:.3f} {:.3f} {:.2f} "
+    "{:.3f})\n",
+    x[0], x[2], x[4], x[7], x[8], center[0], center[1], center[2], w, r);
+  return 0;
+}
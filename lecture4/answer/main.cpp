@@ -1,5 +1,7 @@
 #include "tasks/detector.hpp"
 #include "tools/img_tools.hpp"
+#include "tools/video_source.hpp"
+#include "tools/pnp_tools.hpp"
 #include "fmt/core.h"
 
 // clang-format off
@@ -15,6 +17,7 @@ static const cv::Mat distort_coeffs =
 
 static const double LIGHTBAR_LENGTH = 0.056; // 灯条长度    单位：米
 static const double ARMOR_WIDTH = 0.135;     // 装甲板宽度  单位：米
+static const double MAX_REPROJECTION_RMS = 3.0; // 重投影RMS超过该值的解视为不可信  单位：pixel
 
 // #### Task 01 ############################################
 // object_points 是 物体局部坐标系下 n个点 的坐标。
@@ -33,18 +36,24 @@ static const std::vector<cv::Point3f> object_points{
 // - 在上方定义有 灯条长度 和 装甲板宽度，你应当用 "± ARMOR_WIDTH / 2" 这样的写法来填写。
 // #########################################################
 
+// 用法: ./main [--headless]，headless 模式不显示画面，用于测量处理速度
 int main(int argc, char *argv[])
 {
+    bool headless = argc > 1 && std::string(argv[1]) == "--headless";
+
     auto_aim::Detector detector;
 
-    cv::VideoCapture cap("video.avi");
+    tools::VideoSource cap("video.avi"); // 多线程预解码，用法同 cv::VideoCapture
     cv::Mat img;
 
+    int frame_count = 0;
+    auto begin = std::chrono::steady_clock::now();
+
     while (true)
     {
-        cap >> img;
-        if (img.empty()) // 读取失败 或 视频结尾
+        if (!cap.read(img)) // 读取失败 或 视频结尾
             break;
+        frame_count++;
 
         auto armors = detector.detect(img);
 
@@ -78,6 +87,10 @@ int main(int argc, char *argv[])
             //
             cv::solvePnP(object_points, img_points, camera_matrix, distort_coeffs, rvec, tvec);
             //
+            // 解算质量：重投影误差过大的结果不可信
+            auto quality = tools::evaluate_pnp(object_points, img_points, camera_matrix, distort_coeffs, rvec, tvec);
+            bool trusted = quality.reprojection_rms <= MAX_REPROJECTION_RMS;
+            tools::draw_text(img, fmt::format("rms: {:.2f}px  std(z): {:.3f}m{}", quality.reprojection_rms, std::sqrt(quality.covariance(5, 5)), trusted ? "" : "  untrusted"), cv::Point2f(10, 240), 1.7, trusted ? cv::Scalar(0, 255, 255) : cv::Scalar(0, 0, 255), 3);
             // #########################################################
 
             // #### Task 04 ############################################
@@ -110,12 +123,18 @@ int main(int argc, char *argv[])
             // #########################################################
         }
 
+        if (headless)
+            continue;
+
         cv::imshow("press q to quit", img);
 
         if (cv::waitKey(20) == 'q')
             break;
     }
 
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    fmt::print("{} frames, {:.1f} fps\n", frame_count, frame_count / seconds);
+
     cv::destroyAllWindows();
     return 0;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "tasks/detector.hpp"
 #include "tools/img_tools.hpp"
+#include "tools/video_source.hpp"
 #include "fmt/core.h"
 
 // clang-format off
@@ -35,18 +36,24 @@ static const double ARMOR_WIDTH = 0.135;     // 装甲板宽度  单位：米
 // #########################################################
 
 
+// 用法: ./main [--headless]，headless 模式不显示画面，用于测量处理速度
 int main(int argc, char *argv[])
 {
+    bool headless = argc > 1 && std::string(argv[1]) == "--headless";
+
     auto_aim::Detector detector;
 
-    cv::VideoCapture cap("video.avi");
+    tools::VideoSource cap("video.avi"); // 多线程预解码，用法同 cv::VideoCapture
     cv::Mat img;
 
+    int frame_count = 0;
+    auto begin = std::chrono::steady_clock::now();
+
     while (true)
     {
-        cap >> img;
-        if (img.empty()) // 读取失败 或 视频结尾
+        if (!cap.read(img)) // 读取失败 或 视频结尾
             break;
+        frame_count++;
 
         auto armors = detector.detect(img);
 
@@ -109,12 +116,18 @@ int main(int argc, char *argv[])
 
         }
 
+        if (headless)
+            continue;
+
         cv::imshow("press q to quit", img);
 
         if (cv::waitKey(20) == 'q')
             break;
     }
 
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    fmt::print("{} frames, {:.1f} fps\n", frame_count, frame_count / seconds);
+
     cv::destroyAllWindows();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef TOOLS__PNP_TOOLS_HPP
+#define TOOLS__PNP_TOOLS_HPP
+
+#include <opencv2/opencv.hpp>
+
+namespace tools
+{
+    struct PnPQuality
+    {
+        double reprojection_rms = 0; // 单位: pixel
+        cv::Matx66d covariance;      // [rvec, tvec]的近似协方差
+    };
+
+    // 评估 solvePnP 的结果，依次传入：物体点、图像点、内参、畸变、rvec、tvec
+    // 协方差取 sigma^2 * (J^T J)^-1，J 直接来自 projectPoints，几乎不增加开销
+    inline PnPQuality evaluate_pnp(
+        const std::vector<cv::Point3f> &object_points, const std::vector<cv::Point2f> &image_points,
+        const cv::Mat &camera_matrix, const cv::Mat &dist_coeffs, const cv::Mat &rvec,
+        const cv::Mat &tvec)
+    {
+        PnPQuality quality;
+        if (object_points.empty() || object_points.size() != image_points.size())
+            return quality;
+
+        std::vector<cv::Point2f> projected_points;
+        cv::Mat jacobian;
+        cv::projectPoints(object_points, rvec, tvec, camera_matrix, dist_coeffs, projected_points, jacobian);
+
+        double sse = 0;
+        for (size_t i = 0; i < image_points.size(); i++)
+        {
+            auto error = projected_points[i] - image_points[i];
+            sse += error.dot(error);
+        }
+        int n = static_cast<int>(image_points.size());
+        quality.reprojection_rms = std::sqrt(sse / n);
+
+        cv::Mat J = jacobian.colRange(0, 6);
+        cv::Mat JtJ_inv;
+        cv::invert(J.t() * J, JtJ_inv, cv::DECOMP_SVD);
+        quality.covariance = cv::Matx66d(JtJ_inv) * (sse / std::max(2 * n - 6, 1));
+
+        return quality;
+    }
+} // namespace tools
+
+#endif // TOOLS__PNP_TOOLS_HPP
@@ -0,0 +1,170 @@
+#ifndef TOOLS__VIDEO_SOURCE_HPP
+#define TOOLS__VIDEO_SOURCE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tools
+{
+    // 多线程预解码的视频源，用法与 cv::VideoCapture 的 read 相同
+    // 视频按 chunk 帧切块，每个线程用自己的 VideoCapture 跳转解码，结果按原顺序取出
+    // 跳转无法精确到帧时退化为单线程顺序解码，输出与顺序解码一致
+    class VideoSource
+    {
+    public:
+        // workers 为0时取CPU核数
+        explicit VideoSource(const std::string &path, int workers = 0, size_t buffer_size = 64, int chunk = 32)
+            : path_(path), buffer_size_(std::max<size_t>(buffer_size, chunk)), chunk_(std::max(1, chunk))
+        {
+            cv::VideoCapture cap(path_);
+            opened_ = cap.isOpened();
+            if (!opened_)
+                return;
+
+            // 总帧数未知时无法跳转，退化为单线程顺序解码
+            auto frame_count = static_cast<int64_t>(cap.get(cv::CAP_PROP_FRAME_COUNT));
+            bool seekable = frame_count > 0;
+            if (seekable)
+                end_ = frame_count;
+
+            if (workers <= 0)
+                workers = std::max(1u, std::thread::hardware_concurrency());
+            if (!seekable)
+                workers = 1;
+
+            running_ = workers;
+            for (int i = 0; i < workers; i++)
+                workers_.emplace_back([this, seekable] { work(seekable); });
+        }
+
+        ~VideoSource()
+        {
+            quit_ = true;
+            space_.notify_all();
+            for (auto &worker : workers_)
+                worker.join();
+        }
+
+        bool isOpened() const { return opened_; }
+
+        // 视频结尾或读取失败时返回false
+        bool read(cv::Mat &img)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return buffer_.count(next_) || next_ >= end_ || running_ == 0; });
+
+            auto it = buffer_.find(next_);
+            if (it == buffer_.end())
+                return false;
+
+            img = std::move(it->second);
+            buffer_.erase(it);
+            next_++;
+            space_.notify_all();
+            return true;
+        }
+
+    private:
+        const std::string path_;
+        const size_t buffer_size_;
+        const int chunk_;
+        bool opened_ = false;
+
+        std::map<int64_t, cv::Mat> buffer_; // 帧序号 -> 图像
+        int64_t next_ = 0;                  // 下一个要输出的帧序号
+        int64_t end_ = std::numeric_limits<int64_t>::max();
+        int running_ = 0;
+        std::mutex mutex_;
+        std::condition_variable ready_, space_;
+
+        std::atomic<int64_t> next_chunk_{0};
+        std::atomic<bool> sequential_{false}; // 已退化为顺序解码
+        std::atomic<bool> quit_{false};
+        std::vector<std::thread> workers_;
+
+        // 按帧号跳转，落在之前的关键帧上时向后解码到目标帧；无法确认位置时返回false
+        static bool seek_exact(cv::VideoCapture &cap, int64_t frame)
+        {
+            if (!cap.set(cv::CAP_PROP_POS_FRAMES, frame))
+                return false;
+            auto position = static_cast<int64_t>(cap.get(cv::CAP_PROP_POS_FRAMES));
+            for (auto skip = frame - position; skip > 0 && position < frame && cap.grab(); skip--)
+                position = static_cast<int64_t>(cap.get(cv::CAP_PROP_POS_FRAMES));
+            return position == frame;
+        }
+
+        void work(bool seekable)
+        {
+            cv::VideoCapture cap(path_);
+            int64_t position = 0;
+
+            while (!quit_)
+            {
+                if (seekable && sequential_)
+                    break;
+                auto begin = seekable ? next_chunk_.fetch_add(1) * chunk_ : position;
+                auto end = seekable ? begin + chunk_ : std::numeric_limits<int64_t>::max();
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (begin >= end_)
+                        break;
+                }
+
+                // 跳转不精确时，本线程从头顺序解码到 begin，之后一直顺序解码到结尾
+                if (position != begin && !seek_exact(cap, begin))
+                {
+                    sequential_ = true;
+                    seekable = false;
+                    end = std::numeric_limits<int64_t>::max();
+                    cap.open(path_);
+                    for (position = 0; position < begin && !quit_ && cap.grab(); position++)
+                    {
+                    }
+                    if (position < begin)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        end_ = std::min(end_, position);
+                        ready_.notify_all();
+                        break;
+                    }
+                }
+                position = begin;
+
+                for (; position < end && !quit_; position++)
+                {
+                    cv::Mat img;
+                    if (!cap.read(img) || img.empty())
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        end_ = std::min(end_, position);
+                        ready_.notify_all();
+                        break;
+                    }
+
+                    // 超前太多时等待，持有 next_ 所在块的线程总能继续
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    space_.wait(lock, [&] { return quit_ || position < next_ + int64_t(buffer_size_); });
+                    if (quit_ || position >= end_)
+                        break;
+                    if (position >= next_) // 与其他线程的块重叠时丢弃重复的帧
+                        buffer_.emplace(position, std::move(img));
+                    ready_.notify_all();
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_--;
+            ready_.notify_all();
+        }
+    };
+} // namespace tools
+
+#endif // TOOLS__VIDEO_SOURCE_HPP
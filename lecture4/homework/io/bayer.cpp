@@ -0,0 +1,143 @@
+#include "bayer.hpp"
+
+#include <chrono>
+#include <limits>
+
+#include "tools/logger.hpp"
+
+namespace io
+{
+namespace
+{
+class OpenCVConverter : public BayerConverter
+{
+public:
+  std::string name() const override { return "opencv"; }
+
+  bool convert(const cv::Mat & bayer, int cvt_code, cv::Mat & dst) override
+  {
+    cv::cvtColor(bayer, dst, cvt_code);
+    return true;
+  }
+};
+
+// 处理一行: 本行的非绿色像素记为C(红行为R, 蓝行为B), 上下行的非绿色像素记为D
+// c_first: 本行第一个C像素的列号(0或1); c_channel / d_channel: C与D在BGR中的通道号
+void demosaic_row(
+  const uint8_t * up, const uint8_t * mid, const uint8_t * down, uint8_t * out, int width,
+  int c_first, int c_channel, int d_channel)
+{
+  // 边界列按镜像取邻居, 单独处理
+  auto pixel = [&](int x) {
+    auto left = x > 0 ? x - 1 : x + 1;
+    auto right = x < width - 1 ? x + 1 : x - 1;
+    auto p = out + 3 * x;
+    if ((x & 1) == c_first) {
+      p[c_channel] = mid[x];
+      p[1] = (mid[left] + mid[right] + up[x] + down[x] + 2) >> 2;
+      p[d_channel] = (up[left] + up[right] + down[left] + down[right] + 2) >> 2;
+    } else {
+      p[1] = mid[x];
+      p[c_channel] = (mid[left] + mid[right] + 1) >> 1;
+      p[d_channel] = (up[x] + down[x] + 1) >> 1;
+    }
+  };
+  pixel(0);
+  pixel(width - 1);
+
+  // C像素: 绿色取上下左右平均, D取四个对角平均
+  for (int x = 2 - c_first; x < width - 1; x += 2) {
+    auto p = out + 3 * x;
+    p[c_channel] = mid[x];
+    p[1] = (mid[x - 1] + mid[x + 1] + up[x] + down[x] + 2) >> 2;
+    p[d_channel] = (up[x - 1] + up[x + 1] + down[x - 1] + down[x + 1] + 2) >> 2;
+  }
+
+  // 绿色像素: C取左右平均, D取上下平均
+  for (int x = 1 + c_first; x < width - 1; x += 2) {
+    auto p = out + 3 * x;
+    p[1] = mid[x];
+    p[c_channel] = (mid[x - 1] + mid[x + 1] + 1) >> 1;
+    p[d_channel] = (up[x] + down[x] + 1) >> 1;
+  }
+}
+
+class BilinearConverter : public BayerConverter
+{
+public:
+  std::string name() const override { return "bilinear"; }
+
+  bool convert(const cv::Mat & bayer, int cvt_code, cv::Mat & dst) override
+  {
+    // 红色像素在2x2单元中的位置, 与 HikRobot 中像素格式到 cvt_code 的对应一致
+    int red_x, red_y;
+    switch (cvt_code) {
+      case cv::COLOR_BayerRG2RGB: red_x = 0, red_y = 0; break;
+      case cv::COLOR_BayerGR2RGB: red_x = 1, red_y = 0; break;
+      case cv::COLOR_BayerGB2RGB: red_x = 0, red_y = 1; break;
+      case cv::COLOR_BayerBG2RGB: red_x = 1, red_y = 1; break;
+      default: return false;
+    }
+    if (bayer.rows < 2 || bayer.cols < 2) return false;
+
+    for (int y = 0; y < bayer.rows; y++) {
+      auto up = bayer.ptr<uint8_t>(y > 0 ? y - 1 : y + 1);
+      auto mid = bayer.ptr<uint8_t>(y);
+      auto down = bayer.ptr<uint8_t>(y < bayer.rows - 1 ? y + 1 : y - 1);
+      auto out = dst.ptr<uint8_t>(y);
+
+      if ((y & 1) == red_y)
+        demosaic_row(up, mid, down, out, bayer.cols, red_x, 2, 0);
+      else
+        demosaic_row(up, mid, down, out, bayer.cols, 1 - red_x, 0, 2);
+    }
+    return true;
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<BayerConverter> make_opencv_converter()
+{
+  return std::make_unique<OpenCVConverter>();
+}
+
+std::unique_ptr<BayerConverter> make_bilinear_converter()
+{
+  return std::make_unique<BilinearConverter>();
+}
+
+std::unique_ptr<BayerConverter> select_fastest(
+  std::vector<std::unique_ptr<BayerConverter>> candidates, const cv::Mat & bayer, int cvt_code,
+  int rounds)
+{
+  cv::Mat dst(bayer.rows, bayer.cols, CV_8UC3);
+  size_t best = candidates.size();
+  double best_ms = std::numeric_limits<double>::max();
+
+  for (size_t i = 0; i < candidates.size(); i++) {
+    auto & candidate = candidates[i];
+    if (!candidate->convert(bayer, cvt_code, dst)) {
+      tools::logger()->info("Bayer conversion \"{}\": unsupported", candidate->name());
+      continue;
+    }
+
+    // 第一次转换已作为预热, 取其余各次的平均
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) candidate->convert(bayer, cvt_code, dst);
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin)
+                .count() /
+              std::max(1, rounds);
+
+    tools::logger()->info(
+      "Bayer conversion \"{}\": {:.3f} ms/frame ({}x{})", candidate->name(), ms, bayer.cols,
+      bayer.rows);
+    if (ms < best_ms) best_ms = ms, best = i;
+  }
+
+  if (best == candidates.size()) return make_opencv_converter();
+  tools::logger()->info("Bayer conversion: using \"{}\".", candidates[best]->name());
+  return std::move(candidates[best]);
+}
+
+}  // namespace io
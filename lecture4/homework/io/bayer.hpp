@@ -0,0 +1,37 @@
+#ifndef IO__BAYER_HPP
+#define IO__BAYER_HPP
+
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+namespace io
+{
+// Bayer 原始图转彩色图的实现
+// cvt_code 沿用 RawFrame 中的约定(cv::COLOR_Bayer**2RGB, 与相机像素格式同名), 输出均为BGR顺序
+class BayerConverter
+{
+public:
+  virtual ~BayerConverter() = default;
+  virtual std::string name() const = 0;
+
+  // dst 已按 bayer 的大小分配为 CV_8UC3(通常来自缓冲池), 转换失败时返回 false
+  virtual bool convert(const cv::Mat & bayer, int cvt_code, cv::Mat & dst) = 0;
+};
+
+// cv::cvtColor, 使用OpenCV自带的SIMD实现
+std::unique_ptr<BayerConverter> make_opencv_converter();
+
+// 双线性插值, 按行直接写入输出, 内层循环无分支便于编译器向量化
+std::unique_ptr<BayerConverter> make_bilinear_converter();
+
+// 在样本帧上逐一测试每个候选, 输出各自的单帧耗时, 返回最快的一个
+// 应在相机实际输出的样本帧上调用, 使结果反映实际CPU与分辨率; 耗时数十毫秒, 不要在采集线程上直接调用
+std::unique_ptr<BayerConverter> select_fastest(
+  std::vector<std::unique_ptr<BayerConverter>> candidates, const cv::Mat & bayer, int cvt_code,
+  int rounds = 20);
+
+}  // namespace io
+
+#endif  // IO__BAYER_HPP
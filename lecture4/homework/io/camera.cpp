@@ -3,12 +3,39 @@
 #include <stdexcept>
 
 #include "hikrobot/hikrobot.hpp"
+#ifdef IO_WITH_MINDVISION
+#include "mindvision/mindvision.hpp"
+#endif
+#include "replay/replay.hpp"
 
 namespace io
 {
 Camera::Camera(double exposure_ms, double gain, const std::string & vid_pid)
 {
-  camera_ = std::make_unique<HikRobot>(exposure_ms, gain, vid_pid);
+  CameraConfig config;
+  config.exposure_ms = exposure_ms;
+  config.gain = gain;
+  config.vid_pid = vid_pid;
+  camera_ = std::make_unique<HikRobot>(config);
+}
+
+Camera::Camera(const CameraConfig & config)
+{
+  if (config.backend == CameraBackend::hikrobot) {
+    camera_ = std::make_unique<HikRobot>(config);
+    return;
+  }
+
+#ifdef IO_WITH_MINDVISION
+  camera_ = std::make_unique<MindVision>(config);
+#else
+  throw std::runtime_error("MindVision support is not built, reconfigure with -DWITH_MINDVISION=ON");
+#endif
+}
+
+Camera::Camera(const std::string & replay_path, ReplayMode mode)
+{
+  camera_ = std::make_unique<Replay>(replay_path, mode);
 }
 
 void Camera::read(cv::Mat & img, std::chrono::steady_clock::time_point & timestamp)
@@ -16,4 +43,20 @@ void Camera::read(cv::Mat & img, std::chrono::steady_clock::time_point & timesta
   camera_->read(img, timestamp);
 }
 
+ReadStatus Camera::read_for(CameraFrame & frame, std::chrono::milliseconds timeout)
+{
+  return camera_->read_for(frame, timeout);
+}
+
+ReadStatus Camera::try_read(CameraFrame & frame) { return camera_->try_read(frame); }
+
+void Camera::set_raw_hook(RawFrameHook hook) { camera_->set_raw_hook(std::move(hook)); }
+
+void Camera::set_metering_roi(const cv::Rect & roi) { camera_->set_metering_roi(roi); }
+
+void Camera::set_sensor_roi(const cv::Rect & roi, int binning)
+{
+  camera_->set_sensor_roi(roi, binning);
+}
+
 }  // namespace io
\ No newline at end of file
@@ -2,24 +2,172 @@
 #define IO__CAMERA_HPP
 
 #include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <opencv2/opencv.hpp>
 #include <string>
 
 namespace io
 {
+// 相机SDK输出的原始图像(Bayer), 仅在回调期间有效
+struct RawFrame
+{
+  const uint8_t * data;
+  size_t size;
+  int width;
+  int height;
+  int cvt_code;  // 转为RGB所用的cv::ColorConversionCodes, 单色图为-1
+  uint64_t frame_num;
+  std::chrono::steady_clock::time_point timestamp;
+
+  // 与 CameraFrame 相同, 图像在传感器上的位置
+  cv::Point offset;
+  int binning = 1;
+};
+
+// 一帧图像及其元数据
+struct CameraFrame
+{
+  cv::Mat img;
+  std::chrono::steady_clock::time_point timestamp;  // 主机收到该帧的时刻
+  uint64_t device_timestamp = 0;  // 相机硬件时间戳(相机时钟计数), 0表示不可用
+  uint64_t frame_num = 0;         // 相机帧号, 回放时为录制帧号或视频帧序号
+  uint64_t dropped = 0;  // 与上一次读到的帧之间丢失的帧数, 包括相机/USB丢帧与读取不及时被覆盖的帧
+  double exposure_us = 0;  // 该帧实际的曝光时间, 0表示不可用
+  double gain = 0;
+
+  // 图像在传感器上的位置, 全分辨率坐标 = offset + 图像坐标 * binning
+  cv::Point offset;
+  int binning = 1;
+
+  int camera = 0;  // 拍摄该帧的相机, 即 CameraGroup 中的序号; 单相机时为0
+};
+
+// 在采集线程上调用, 不允许阻塞
+using RawFrameHook = std::function<void(const RawFrame &)>;
+
+// 回放节奏
+// realtime: 按录制时间戳播放, 处理不过来的帧被丢弃, 与实际相机一致
+// fast: 不等待, 逐帧尽快播放
+// lockstep: 按录制节奏播放但不丢帧, 处理慢时回放时钟随之暂停
+enum class ReplayMode
+{
+  realtime,
+  fast,
+  lockstep
+};
+
+// 多相机同步采集时的硬件触发方式
+// free_run: 不使用触发; master: 自由运行, 并从 Line1 输出曝光信号; slave: 由 Line0 的上升沿触发曝光
+enum class Trigger
+{
+  free_run,
+  master,
+  slave
+};
+
+// 自动曝光: 让测光区域内亮部(percentile 分位)的亮度接近 target, 曝光时间到上限后再提高增益
+// 灯条与符叶只占画面很小一部分, 因此看高分位亮度而不是均值
+struct ExposureControl
+{
+  bool enabled = false;
+  double target = 200;        // 分位亮度的目标值(0-255)
+  double percentile = 0.99;
+  double tolerance = 0.1;     // 相对误差在此范围内不调整, 避免来回振荡
+  double damping = 0.5;       // 每次只补偿误差的一部分(对数域)
+  double min_exposure_ms = 0.5;
+  double max_exposure_ms = 5;  // 曝光过长时运动模糊, 超出部分由增益补足
+  double min_gain = 0;         // dB
+  double max_gain = 16.9;
+  double rate_hz = 10;
+  int subsample = 4;  // 每隔 subsample 行/列取一个像素统计直方图
+};
+
+// 相机品牌, mindvision 需以 -DWITH_MINDVISION=ON 编译
+enum class CameraBackend
+{
+  hikrobot,
+  mindvision
+};
+
+// Bayer转彩色的实现, automatic 在第一帧上测试各实现后选用最快的
+enum class BayerBackend
+{
+  automatic,
+  sdk,
+  opencv,
+  bilinear
+};
+
+// 相机参数, 多台相机时用序列号区分
+struct CameraConfig
+{
+  CameraBackend backend = CameraBackend::hikrobot;
+  double exposure_ms = 2.5;
+  double gain = 16.9;
+  std::string vid_pid = "2bdf:0001";  // 未指定序列号时按它筛选设备, 掉线时按它复位USB
+  std::string serial;                 // 为空时打开第一台匹配 vid_pid 的相机
+  Trigger trigger = Trigger::free_run;
+  ExposureControl exposure_control;
+  BayerBackend bayer = BayerBackend::automatic;
+
+  // 传感器端ROI(全分辨率坐标, 空矩形为整个传感器)与合并倍数, 只传输需要的像素以提高帧率
+  cv::Rect sensor_roi;
+  int binning = 1;
+  double frame_rate = 150;  // 0 表示不限帧率, 由曝光时间与ROI大小决定
+};
+
+// 有时限读取的结果
+// ok: 取得新帧; timeout: 时限内没有新帧; reconnecting: 相机掉线, 正在恢复; end: 回放结束
+enum class ReadStatus
+{
+  ok,
+  timeout,
+  reconnecting,
+  end
+};
+
 class CameraBase
 {
 public:
   virtual ~CameraBase() = default;
   virtual void read(cv::Mat & img, std::chrono::steady_clock::time_point & timestamp) = 0;
+
+  // 最多等待 timeout, 相机掉线时不会无限阻塞; 默认实现用于本身不会长时间阻塞的数据源
+  virtual ReadStatus read_for(CameraFrame & frame, std::chrono::milliseconds)
+  {
+    read(frame.img, frame.timestamp);
+    return frame.img.empty() ? ReadStatus::end : ReadStatus::ok;
+  }
+
+  // 不等待, 没有新帧时立即返回 timeout, 供固定频率的控制循环使用
+  ReadStatus try_read(CameraFrame & frame) { return read_for(frame, std::chrono::milliseconds(0)); }
+
+  virtual void set_raw_hook(RawFrameHook) {}
+
+  // 自动曝光的测光区域(如检测到的能量机关), 全分辨率坐标, 空矩形表示整幅图像
+  virtual void set_metering_roi(const cv::Rect &) {}
+
+  // 运行时修改传感器端ROI与合并倍数, 异步生效, 之后的帧通过 offset/binning 标明所在位置
+  virtual void set_sensor_roi(const cv::Rect &, int) {}
 };
 
 class Camera
 {
 public:
   Camera(double exposure_ms, double gain, const std::string & vid_pid);
+  explicit Camera(const CameraConfig & config);
+
+  // 回放录制目录或视频文件, 播放结束后 read 返回空图像
+  Camera(const std::string & replay_path, ReplayMode mode);
+
   void read(cv::Mat & img, std::chrono::steady_clock::time_point & timestamp);
+  ReadStatus read_for(CameraFrame & frame, std::chrono::milliseconds timeout);
+  ReadStatus try_read(CameraFrame & frame);
+  void set_raw_hook(RawFrameHook hook);
+  void set_metering_roi(const cv::Rect & roi);
+  void set_sensor_roi(const cv::Rect & roi, int binning = 1);
 
 private:
   std::unique_ptr<CameraBase> camera_;
@@ -0,0 +1,111 @@
+#include "camera_group.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace io
+{
+CameraGroup::CameraGroup(
+  const std::vector<CameraConfig> & configs, std::chrono::microseconds tolerance)
+: tolerance_(tolerance),
+  pending_(configs.size()),
+  skipped_(configs.size(), 0),
+  unmatched_(0)
+{
+  if (configs.empty()) throw std::invalid_argument("CameraGroup needs at least one camera");
+
+  for (const auto & config : configs) cameras_.push_back(std::make_unique<Camera>(config));
+}
+
+ReadStatus CameraGroup::read_for(
+  std::vector<CameraFrame> & frames, std::chrono::milliseconds timeout)
+{
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+
+  while (true) {
+    // 先取走各相机已经到达的帧, 不等待
+    for (size_t i = 0; i < cameras_.size(); i++) {
+      CameraFrame frame;
+      while (cameras_[i]->try_read(frame) == ReadStatus::ok) push(i, std::move(frame));
+    }
+
+    if (match(frames)) return ReadStatus::ok;
+
+    // 没有配对成功: 等待最新一帧最旧的相机, 其余相机的帧留待下一轮
+    size_t lagging = 0;
+    for (size_t i = 0; i < cameras_.size(); i++) {
+      if (pending_[i].empty()) {
+        lagging = i;
+        break;
+      }
+      if (pending_[i].back().timestamp < pending_[lagging].back().timestamp) lagging = i;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) return ReadStatus::timeout;
+
+    auto remaining = std::max(
+      std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now),
+      std::chrono::milliseconds(1));
+    CameraFrame frame;
+    auto status = cameras_[lagging]->read_for(frame, remaining);
+    if (status == ReadStatus::ok)
+      push(lagging, std::move(frame));
+    else if (status != ReadStatus::timeout)
+      return status;
+  }
+}
+
+void CameraGroup::push(size_t index, CameraFrame && frame)
+{
+  auto & pending = pending_[index];
+  pending.push_back(std::move(frame));
+  if (pending.size() <= HISTORY) return;
+
+  skipped_[index] += 1 + pending.front().dropped;
+  unmatched_++;
+  pending.pop_front();
+}
+
+// 从基准相机最新的帧开始, 在其他相机的待配对帧中找时间戳最接近的一帧
+bool CameraGroup::match(std::vector<CameraFrame> & frames)
+{
+  std::vector<size_t> indices(cameras_.size());
+  for (auto anchor = pending_[0].rbegin(); anchor != pending_[0].rend(); ++anchor) {
+    indices[0] = pending_[0].size() - 1 - (anchor - pending_[0].rbegin());
+
+    bool matched = true;
+    for (size_t i = 1; i < cameras_.size() && matched; i++) {
+      auto best = tolerance_ + std::chrono::microseconds(1);
+      for (size_t j = 0; j < pending_[i].size(); j++) {
+        auto skew = std::chrono::duration_cast<std::chrono::microseconds>(
+          pending_[i][j].timestamp - anchor->timestamp);
+        if (std::chrono::abs(skew) < best) best = std::chrono::abs(skew), indices[i] = j;
+      }
+      matched = best <= tolerance_;
+    }
+    if (!matched) continue;
+
+    // 配对帧之前的帧都不会再被用到, 一并丢弃
+    frames.resize(cameras_.size());
+    for (size_t i = 0; i < cameras_.size(); i++) {
+      auto & pending = pending_[i];
+      for (size_t j = 0; j < indices[i]; j++) {
+        skipped_[i] += 1 + pending.front().dropped;
+        unmatched_++;
+        pending.pop_front();
+      }
+
+      frames[i] = std::move(pending.front());
+      pending.pop_front();
+      frames[i].camera = static_cast<int>(i);
+      frames[i].dropped += skipped_[i];
+      skipped_[i] = 0;
+    }
+    return true;
+  }
+
+  return false;
+}
+
+}  // namespace io
@@ -0,0 +1,50 @@
+#ifndef IO__CAMERA_GROUP_HPP
+#define IO__CAMERA_GROUP_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "io/camera.hpp"
+
+namespace io
+{
+// 多相机同步采集: 每台相机各自的采集线程与图像缓冲池, 按主机时间戳把各相机的帧配成一组
+// 相机之间的硬件时间戳来自各自的时钟, 不能直接比较, 因此用主机收到帧的时刻配对;
+// 使用硬件触发(Trigger::master/slave)时同组帧的曝光时刻一致, 主机时间戳只差USB传输的抖动
+class CameraGroup
+{
+public:
+  // configs[0] 为基准相机, 其余相机的帧与它的帧配对
+  explicit CameraGroup(
+    const std::vector<CameraConfig> & configs,
+    std::chrono::microseconds tolerance = std::chrono::milliseconds(3));
+
+  // 最多等待 timeout 读取一组帧, frames[i] 对应 configs[i]
+  // 成功时各帧时间戳与基准帧相差不超过 tolerance; dropped 包含因无法配对而丢弃的帧
+  ReadStatus read_for(std::vector<CameraFrame> & frames, std::chrono::milliseconds timeout);
+
+  size_t size() const { return cameras_.size(); }
+  Camera & camera(size_t index) { return *cameras_[index]; }
+
+  // 因找不到配对而丢弃的帧数
+  uint64_t unmatched() const { return unmatched_; }
+
+private:
+  static constexpr size_t HISTORY = 4;  // 每台相机最多保留的待配对帧数
+
+  const std::chrono::microseconds tolerance_;
+  std::vector<std::unique_ptr<Camera>> cameras_;
+  std::vector<std::deque<CameraFrame>> pending_;  // 按时间先后排列
+  std::vector<uint64_t> skipped_;                 // 配对前被丢弃的帧数, 计入下一次输出的 dropped
+  uint64_t unmatched_;
+
+  void push(size_t index, CameraFrame && frame);
+  bool match(std::vector<CameraFrame> & frames);
+};
+
+}  // namespace io
+
+#endif  // IO__CAMERA_GROUP_HPP
@@ -0,0 +1,69 @@
+#include "exposure_controller.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace io
+{
+ExposureController::ExposureController(const ExposureControl & config)
+: config_(config), measured_(0)
+{
+}
+
+bool ExposureController::update(
+  const cv::Mat & img, const cv::Rect & roi, double & exposure_us, double & gain)
+{
+  if (img.empty()) return false;
+
+  auto area = roi & cv::Rect(0, 0, img.cols, img.rows);
+  measured_ = percentile_value(area.empty() ? img : img(area));
+
+  // 亮部已饱和时无法得知过曝多少, 按固定比例减半
+  auto ratio = measured_ >= 255 ? 0.5 : config_.target / std::max(measured_, 1);
+  if (std::abs(std::log(ratio)) < std::log(1 + config_.tolerance)) return false;
+
+  // 总增益 = 曝光时间 x 模拟增益, 优先用曝光时间补偿, 不够时再调增益
+  auto min_exposure_us = config_.min_exposure_ms * 1e3;
+  auto max_exposure_us = config_.max_exposure_ms * 1e3;
+  auto total = exposure_us * std::pow(10, gain / 20) * std::pow(ratio, config_.damping);
+
+  auto new_exposure_us =
+    std::clamp(total / std::pow(10, config_.min_gain / 20), min_exposure_us, max_exposure_us);
+  auto new_gain = std::clamp(
+    20 * std::log10(total / new_exposure_us), config_.min_gain, config_.max_gain);
+
+  if (std::abs(new_exposure_us - exposure_us) < 1 && std::abs(new_gain - gain) < 0.1) return false;
+  exposure_us = new_exposure_us;
+  gain = new_gain;
+  return true;
+}
+
+// 每隔 subsample 行列取一个像素, 以各通道的最大值作为亮度(灯条常在单个通道饱和)
+int ExposureController::percentile_value(const cv::Mat & img) const
+{
+  std::array<int, 256> hist{};
+  int count = 0;
+  auto step = std::max(1, config_.subsample);
+  auto channels = img.channels();
+  for (int row = 0; row < img.rows; row += step) {
+    auto ptr = img.ptr<uint8_t>(row);
+    for (int col = 0; col < img.cols; col += step) {
+      auto pixel = ptr + col * channels;
+      auto value = pixel[0];
+      for (int c = 1; c < channels; c++) value = std::max(value, pixel[c]);
+      hist[value]++;
+      count++;
+    }
+  }
+
+  auto threshold = static_cast<int>(config_.percentile * count);
+  int accumulated = 0;
+  for (int value = 0; value < 256; value++) {
+    accumulated += hist[value];
+    if (accumulated > threshold) return value;
+  }
+  return 255;
+}
+
+}  // namespace io
@@ -0,0 +1,32 @@
+#ifndef IO__EXPOSURE_CONTROLLER_HPP
+#define IO__EXPOSURE_CONTROLLER_HPP
+
+#include <opencv2/opencv.hpp>
+
+#include "io/camera.hpp"
+
+namespace io
+{
+// 自动曝光的控制律, 与具体相机无关
+// 每次 update 统计一帧的亮度直方图, 按目标亮度给出新的曝光时间与增益
+class ExposureController
+{
+public:
+  explicit ExposureController(const ExposureControl & config);
+
+  // exposure_us 与 gain(dB) 为当前生效的值, 需要调整时改写并返回 true
+  bool update(const cv::Mat & img, const cv::Rect & roi, double & exposure_us, double & gain);
+
+  // 最近一次统计得到的分位亮度
+  int measured() const { return measured_; }
+
+private:
+  const ExposureControl config_;
+  int measured_;
+
+  int percentile_value(const cv::Mat & img) const;
+};
+
+}  // namespace io
+
+#endif  // IO__EXPOSURE_CONTROLLER_HPP
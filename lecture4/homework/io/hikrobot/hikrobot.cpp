@@ -2,35 +2,116 @@
 
 #include <libusb-1.0/libusb.h>
 
+#include <cstring>
+
 #include "tools/logger.hpp"
+#include "tools/thread_config.hpp"
 
 using namespace std::chrono_literals;
 
 namespace io
 {
-HikRobot::HikRobot(double exposure_ms, double gain, const std::string & vid_pid)
-: exposure_us_(exposure_ms * 1e3), gain_(gain), queue_(1), daemon_quit_(false), vid_(-1), pid_(-1)
+namespace
 {
-  set_vid_pid(vid_pid);
-  if (libusb_init(NULL)) tools::logger()->warn("Unable to init libusb!");
-
-  daemon_thread_ = std::thread{[this] {
-    tools::logger()->info("HikRobot's daemon thread started.");
-
-    capture_start();
-
-    while (!daemon_quit_) {
-      std::this_thread::sleep_for(100ms);
+std::string serial_number(const MV_CC_DEVICE_INFO & info)
+{
+  auto serial = reinterpret_cast<const char *>(info.SpecialInfo.stUsb3VInfo.chSerialNumber);
+  return std::string(serial, strnlen(serial, INFO_MAX_BUFFER_SIZE));
+}
 
-      if (capturing_) continue;
+// 像素格式与 cv::COLOR_Bayer**2RGB 同名对应, 转换结果为BGR顺序; 不支持的格式返回-1
+int cvt_code(MvGvspPixelType pixel_type)
+{
+  switch (pixel_type) {
+    case PixelType_Gvsp_BayerGR8: return cv::COLOR_BayerGR2RGB;
+    case PixelType_Gvsp_BayerRG8: return cv::COLOR_BayerRG2RGB;
+    case PixelType_Gvsp_BayerGB8: return cv::COLOR_BayerGB2RGB;
+    case PixelType_Gvsp_BayerBG8: return cv::COLOR_BayerBG2RGB;
+    default: return -1;
+  }
+}
 
-      capture_stop();
-      reset_usb();
-      capture_start();
+// SDK自带的转换, 重连后句柄会变化, 因此保存句柄的引用
+class SdkConverter : public BayerConverter
+{
+public:
+  explicit SdkConverter(void * const & handle) : handle_(handle) {}
+
+  std::string name() const override { return "sdk"; }
+
+  bool convert(const cv::Mat & bayer, int cvt_code, cv::Mat & dst) override
+  {
+    MV_CC_PIXEL_CONVERT_PARAM param{};
+    switch (cvt_code) {
+      case cv::COLOR_BayerGR2RGB: param.enSrcPixelType = PixelType_Gvsp_BayerGR8; break;
+      case cv::COLOR_BayerRG2RGB: param.enSrcPixelType = PixelType_Gvsp_BayerRG8; break;
+      case cv::COLOR_BayerGB2RGB: param.enSrcPixelType = PixelType_Gvsp_BayerGB8; break;
+      case cv::COLOR_BayerBG2RGB: param.enSrcPixelType = PixelType_Gvsp_BayerBG8; break;
+      default: return false;
     }
 
-    capture_stop();
+    param.nWidth = bayer.cols;
+    param.nHeight = bayer.rows;
+    param.pSrcData = const_cast<unsigned char *>(bayer.data);
+    param.nSrcDataLen = bayer.total();
+    param.pDstBuffer = dst.data;
+    param.nDstBufferSize = dst.total() * dst.elemSize();
+    param.enDstPixelType = PixelType_Gvsp_BGR8_Packed;
+    return handle_ && MV_CC_ConvertPixelType(handle_, &param) == MV_OK;
+  }
+
+private:
+  void * const & handle_;
+};
+
+}  // namespace
+
+HikRobot::HikRobot(const CameraConfig & config)
+: exposure_us_(config.exposure_ms * 1e3),
+  gain_(config.gain),
+  serial_(config.serial),
+  trigger_(config.trigger),
+  frame_rate_(config.frame_rate),
+  bayer_backend_(config.bayer),
+  watchdog_(std::max<int>(30, 5 * 1000 / (frame_rate_ > 0 ? frame_rate_ : FRAME_RATE))),
+  daemon_quit_(false),
+  handle_(nullptr),
+  capturing_(false),
+  capture_quit_(false),
+  queue_(1),
+  pool_(8),
+  fallback_converter_(make_opencv_converter()),
+  convert_ms_total_(0),
+  convert_count_(0),
+  sample_sent_(false),
+  sample_cvt_code_(-1),
+  sample_pending_(false),
+  converter_selected_(false),
+  state_(State::connecting),
+  disconnected_(false),
+  last_frame_ns_(0),
+  attempts_(0),
+  has_device_info_(false),
+  has_last_frame_(false),
+  last_frame_num_(0),
+  vid_(-1),
+  pid_(-1),
+  exposure_control_(config.exposure_control),
+  exposure_controller_(config.exposure_control),
+  metering_request_(false),
+  requested_roi_(config.sensor_roi),
+  requested_binning_(config.binning),
+  window_changed_(false),
+  binning_(1)
+{
+  set_vid_pid(config.vid_pid);
+  if (bayer_backend_ != BayerBackend::automatic) converter_ = make_converter(bayer_backend_);
+  if (libusb_init(NULL)) tools::logger()->warn("Unable to init libusb!");
 
+  daemon_thread_ = std::thread{[this] {
+    tools::apply_thread_policy("camera_daemon");
+    tools::logger()->info("HikRobot's daemon thread started.");
+    daemon_loop();
     tools::logger()->info("HikRobot's daemon thread stopped.");
   }};
 }
@@ -38,171 +119,665 @@ HikRobot::HikRobot(double exposure_ms, double gain, const std::string & vid_pid)
 HikRobot::~HikRobot()
 {
   daemon_quit_ = true;
+  wake_daemon();
   if (daemon_thread_.joinable()) daemon_thread_.join();
-  tools::logger()->info("HikRobot destructed.");
+
+  auto stats = outages();
+  tools::logger()->info(
+    "HikRobot destructed, {} outages, max {:.0f} ms, total {:.0f} ms.", stats.count, stats.max_ms,
+    stats.total_ms);
+
+  if (converter_ && convert_count_ > 0)
+    tools::logger()->info(
+      "Bayer conversion \"{}\": {:.3f} ms/frame over {} frames.", converter_->name(),
+      convert_ms_total_ / convert_count_, convert_count_);
 }
 
 void HikRobot::read(cv::Mat & img, std::chrono::steady_clock::time_point & timestamp)
 {
-  CameraData data;
-  queue_.pop(data);
+  CameraFrame frame;
+  while (read_for(frame, std::chrono::seconds(1)) != ReadStatus::ok) continue;
 
-  img = data.img;
-  timestamp = data.timestamp;
+  img = frame.img;
+  timestamp = frame.timestamp;
 }
 
-void HikRobot::capture_start()
+ReadStatus HikRobot::read_for(CameraFrame & frame, std::chrono::milliseconds timeout)
 {
-  capturing_ = false;
-  capture_quit_ = false;
+  if (!queue_.pop_for(frame, timeout))
+    return state_ == State::streaming ? ReadStatus::timeout : ReadStatus::reconnecting;
+
+  // 帧号不连续即为丢帧; 重连后相机帧号从头计数, 此时无法得知丢了多少
+  frame.dropped = has_last_frame_ && frame.frame_num > last_frame_num_
+                    ? frame.frame_num - last_frame_num_ - 1
+                    : 0;
+  has_last_frame_ = true;
+  last_frame_num_ = frame.frame_num;
+  return ReadStatus::ok;
+}
 
-  unsigned int ret;
+void HikRobot::set_raw_hook(RawFrameHook hook)
+{
+  std::lock_guard<std::mutex> lock(raw_hook_mutex_);
+  raw_hook_ = std::move(hook);
+}
 
-  MV_CC_DEVICE_INFO_LIST device_list;
-  ret = MV_CC_EnumDevices(MV_USB_DEVICE, &device_list);
-  if (ret != MV_OK) {
-    tools::logger()->warn("MV_CC_EnumDevices failed: {:#x}", ret);
-    return;
+void HikRobot::set_metering_roi(const cv::Rect & roi)
+{
+  std::lock_guard<std::mutex> lock(metering_mutex_);
+  metering_roi_ = roi;
+}
+
+void HikRobot::set_sensor_roi(const cv::Rect & roi, int binning)
+{
+  {
+    std::lock_guard<std::mutex> lock(window_mutex_);
+    if (roi == requested_roi_ && binning == requested_binning_) return;
+    requested_roi_ = roi;
+    requested_binning_ = binning;
   }
+  window_changed_ = true;
+  wake_daemon();
+}
 
-  if (device_list.nDeviceNum == 0) {
-    tools::logger()->warn("Not found camera!");
-    return;
+HikRobot::OutageStats HikRobot::outages() const
+{
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return stats_;
+}
+
+void HikRobot::daemon_loop()
+{
+  while (!daemon_quit_) {
+    if (need_recovery()) {
+      recover();
+      continue;
+    }
+
+    // 看门狗: 定期检查, 掉线回调与采集线程退出会提前唤醒
+    std::unique_lock<std::mutex> lock(daemon_mutex_);
+    daemon_condition_.wait_for(lock, watchdog_ / 2, [this] {
+      return daemon_quit_ || disconnected_ || !capturing_ ||
+             ((window_changed_ || sample_pending_) && state_ == State::streaming);
+    });
+    lock.unlock();
+
+    // 句柄只在守护线程上开关, 在这里设置曝光与ROI不会与重连冲突
+    if (state_ != State::streaming) continue;
+    if (sample_pending_) select_converter();
+    if (window_changed_.exchange(false)) apply_window();
+    update_exposure();
   }
 
-  ret = MV_CC_CreateHandle(&handle_, device_list.pDeviceInfo[0]);
+  stop_grabbing();
+  close();
+}
+
+bool HikRobot::need_recovery() const
+{
+  if (disconnected_ || !capturing_) return true;
+
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  if (now - std::chrono::steady_clock::duration(last_frame_ns_) <= watchdog_) return false;
+
+  // 从相机只在主相机曝光时出图, 主相机恢复或修改ROI期间停图是正常的
+  // 因此只在设备确实断开时恢复, 避免主相机停流时所有从相机逐级重开、复位USB
+  if (trigger_ == Trigger::slave) return handle_ && !MV_CC_IsDeviceConnected(handle_);
+  return true;
+}
+
+// 逐级恢复, 每次调用尝试一级, 出图后 attempts_ 清零
+// 1. 设备仍在线, 只是取流停滞: 只重启取流
+// 2-3. 关闭后用缓存的设备信息直接重开, 省去枚举
+// 之后: 复位USB, 重新枚举
+void HikRobot::recover()
+{
+  if (state_ == State::streaming) {
+    state_ = State::recovering;
+    outage_begin_ =
+      std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last_frame_ns_));
+    tools::logger()->warn(
+      "HikRobot lost ({}), recovering...", disconnected_ ? "disconnected" : "no frame");
+  }
+
+  auto attempt = ++attempts_;
+  stop_grabbing();
+
+  if (attempt == 1 && !disconnected_ && handle_ && MV_CC_IsDeviceConnected(handle_)) {
+    if (start_grabbing()) return;
+  }
+
+  close();
+  disconnected_ = false;
+
+  auto enumerate = !has_device_info_ || attempt > 3;
+  if (attempt > 3 && state_ == State::recovering) reset_usb();
+  if (open(enumerate) && start_grabbing()) return;
+
+  close();
+  auto backoff = std::min(std::chrono::milliseconds(10 * attempt), std::chrono::milliseconds(200));
+  std::unique_lock<std::mutex> lock(daemon_mutex_);
+  daemon_condition_.wait_for(lock, backoff, [this] { return daemon_quit_.load(); });
+}
+
+// 宽高在取流时不可修改, 因此先停流, 设置后重新取流; 状态保持 streaming, 不计为掉线
+void HikRobot::apply_window()
+{
+  auto begin = std::chrono::steady_clock::now();
+  stop_grabbing();
+  auto size = set_window();
+  if (!start_grabbing()) return;  // 失败时由看门狗进入恢复流程
+
+  tools::logger()->info(
+    "HikRobot window {}x{} at ({}, {}) binning {} applied in {:.0f} ms.", size.width, size.height,
+    offset_.x, offset_.y, binning_,
+    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+}
+
+// 设置合并倍数与ROI, 需在停流状态下调用; 按相机的步进对齐并限制在传感器范围内
+cv::Size HikRobot::set_window()
+{
+  cv::Rect roi;
+  int binning;
+  {
+    std::lock_guard<std::mutex> lock(window_mutex_);
+    roi = requested_roi_;
+    binning = std::max(1, requested_binning_);
+  }
+
+  // 彩色传感器不一定支持合并(会混合Bayer像素), 此时退回抽样
+  binning_ = 1;
+  if (
+    MV_CC_SetEnumValue(handle_, "BinningHorizontal", binning) == MV_OK &&
+    MV_CC_SetEnumValue(handle_, "BinningVertical", binning) == MV_OK) {
+    binning_ = binning;
+  } else if (
+    MV_CC_SetEnumValue(handle_, "DecimationHorizontal", binning) == MV_OK &&
+    MV_CC_SetEnumValue(handle_, "DecimationVertical", binning) == MV_OK) {
+    binning_ = binning;
+  } else if (binning > 1) {
+    tools::logger()->warn("HikRobot does not support binning or decimation {}.", binning);
+  }
+
+  // 先清零偏移, 才能读到当前合并倍数下的最大宽高
+  set_int_value("OffsetX", 0);
+  set_int_value("OffsetY", 0);
+  auto width = get_int_value("Width");
+  auto height = get_int_value("Height");
+  auto offset_x = get_int_value("OffsetX");
+  auto offset_y = get_int_value("OffsetY");
+
+  auto align = [](int64_t value, const MVCC_INTVALUE_EX & info) {
+    auto inc = std::max<int64_t>(1, info.nInc);
+    return std::clamp((value - info.nMin) / inc * inc + info.nMin, info.nMin, info.nMax);
+  };
+
+  // 偏移向下对齐; 偏移的上限随当前宽高变化, 这里只按步长对齐, 由传感器宽高限制
+  auto align_down = [](int64_t value, const MVCC_INTVALUE_EX & info) {
+    auto inc = std::max<int64_t>(1, info.nInc);
+    return std::max(info.nMin, (value - info.nMin) / inc * inc + info.nMin);
+  };
+
+  // ROI 为空时使用整个传感器; 偏移向下对齐, 宽高从对齐后的偏移算到ROI右下角再向上对齐,
+  // 保证覆盖请求的区域; 超出传感器时整体向左上移动
+  int64_t w = width.nMax, h = height.nMax, x = 0, y = 0;
+  if (!roi.empty()) {
+    x = align_down(std::clamp<int64_t>(roi.x / binning_, 0, width.nMax), offset_x);
+    y = align_down(std::clamp<int64_t>(roi.y / binning_, 0, height.nMax), offset_y);
+    auto right = (int64_t(roi.x) + roi.width + binning_ - 1) / binning_;
+    auto bottom = (int64_t(roi.y) + roi.height + binning_ - 1) / binning_;
+    w = align(right - x + std::max<int64_t>(1, width.nInc) - 1, width);
+    h = align(bottom - y + std::max<int64_t>(1, height.nInc) - 1, height);
+    x = align_down(std::min(x, width.nMax - w), offset_x);
+    y = align_down(std::min(y, height.nMax - h), offset_y);
+  }
+
+  set_int_value("Width", w);
+  set_int_value("Height", h);
+  set_int_value("OffsetX", x);
+  set_int_value("OffsetY", y);
+  offset_ = cv::Point(x * binning_, y * binning_);
+
+  // 画幅变小后传输与转换的像素减少, 可以以更高帧率运行; frame_rate 为0时不限帧率才能体现, 否则仍按 frame_rate 限制
+  if (frame_rate_ > 0) {
+    set_bool_value("AcquisitionFrameRateEnable", true);
+    MV_CC_SetFrameRate(handle_, frame_rate_);
+  } else {
+    set_bool_value("AcquisitionFrameRateEnable", false);
+  }
+  return cv::Size(w, h);
+}
+
+void HikRobot::update_exposure()
+{
+  if (!exposure_control_.enabled) return;
+
+  auto now = std::chrono::steady_clock::now();
+  if (now < next_exposure_update_) return;
+
+  CameraFrame frame;
+  cv::Rect roi;
+  {
+    std::lock_guard<std::mutex> lock(metering_mutex_);
+    frame = std::move(metering_frame_);
+    metering_frame_ = CameraFrame();
+    roi = metering_roi_;
+  }
+
+  // 先请求一帧, 下一次唤醒时再统计
+  metering_request_ = true;
+  if (frame.img.empty()) return;
+  next_exposure_update_ =
+    now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1 / std::max(exposure_control_.rate_hz, 0.1)));
+
+  auto exposure_us = exposure_us_, gain = gain_;
+  // 测光区域换算到该帧的图像坐标
+  if (!roi.empty()) {
+    auto b = frame.binning;
+    roi = cv::Rect(
+      (roi.x - frame.offset.x) / b, (roi.y - frame.offset.y) / b, roi.width / b, roi.height / b);
+  }
+  if (!exposure_controller_.update(frame.img, roi, exposure_us, gain)) return;
+
+  // 取流时可直接修改, 从下一次曝光起生效; 重连时 open 会沿用这里的值
+  if (exposure_us != exposure_us_) set_float_value("ExposureTime", exposure_us);
+  if (gain != gain_) set_float_value("Gain", gain);
+  exposure_us_ = exposure_us;
+  gain_ = gain;
+  tools::logger()->debug(
+    "HikRobot exposure {:.0f} us, gain {:.1f} dB (p{:.0f} brightness {}).", exposure_us_, gain_,
+    exposure_control_.percentile * 100, exposure_controller_.measured());
+}
+
+void HikRobot::wake_daemon()
+{
+  std::lock_guard<std::mutex> lock(daemon_mutex_);
+  daemon_condition_.notify_all();
+}
+
+bool HikRobot::open(bool enumerate)
+{
+  unsigned int ret;
+
+  if (enumerate) {
+    MV_CC_DEVICE_INFO_LIST device_list;
+    ret = MV_CC_EnumDevices(MV_USB_DEVICE, &device_list);
+    if (ret != MV_OK) {
+      TOOLS_WARN_EVERY(1s, "MV_CC_EnumDevices failed: {:#x}", ret);
+      return false;
+    }
+
+    if (device_list.nDeviceNum == 0) {
+      TOOLS_WARN_EVERY(1s, "Not found camera!");
+      return false;
+    }
+
+    if (!select_device(device_list)) return false;
+  }
+
+  ret = MV_CC_CreateHandle(&handle_, &device_info_);
   if (ret != MV_OK) {
-    tools::logger()->warn("MV_CC_CreateHandle failed: {:#x}", ret);
-    return;
+    TOOLS_WARN_EVERY(1s, "MV_CC_CreateHandle failed: {:#x}", ret);
+    handle_ = nullptr;
+    return false;
   }
 
   ret = MV_CC_OpenDevice(handle_);
   if (ret != MV_OK) {
-    tools::logger()->warn("MV_CC_OpenDevice failed: {:#x}", ret);
-    return;
+    TOOLS_WARN_EVERY(1s, "MV_CC_OpenDevice failed: {:#x}", ret);
+    return false;
   }
 
+  // 设备断开时SDK立即回调, 比看门狗更早发现掉线
+  ret = MV_CC_RegisterExceptionCallBack(handle_, &HikRobot::on_exception, this);
+  if (ret != MV_OK) tools::logger()->warn("MV_CC_RegisterExceptionCallBack failed: {:#x}", ret);
+
   set_enum_value("BalanceWhiteAuto", MV_BALANCEWHITE_AUTO_CONTINUOUS);
   set_enum_value("ExposureAuto", MV_EXPOSURE_AUTO_MODE_OFF);
   set_enum_value("GainAuto", MV_GAIN_MODE_OFF);
   set_float_value("ExposureTime", exposure_us_);
   set_float_value("Gain", gain_);
-  MV_CC_SetFrameRate(handle_, 150);
+  set_trigger();
+  set_window();
+  return true;
+}
 
-  ret = MV_CC_StartGrabbing(handle_);
-  if (ret != MV_OK) {
-    tools::logger()->warn("MV_CC_StartGrabbing failed: {:#x}", ret);
-    return;
+// 指定了序列号时只打开该相机; 否则取第一台 VID:PID 匹配的相机, 都不匹配时退回第一台
+bool HikRobot::select_device(const MV_CC_DEVICE_INFO_LIST & device_list)
+{
+  const MV_CC_DEVICE_INFO * selected = nullptr;
+  for (unsigned int i = 0; i < device_list.nDeviceNum; i++) {
+    const auto & info = *device_list.pDeviceInfo[i];
+    if (info.nTLayerType != MV_USB_DEVICE) continue;
+
+    const auto & usb = info.SpecialInfo.stUsb3VInfo;
+    if (!serial_.empty()) {
+      if (serial_number(info) == serial_) selected = &info;
+    } else if (static_cast<int>(usb.idVendor) == vid_ && static_cast<int>(usb.idProduct) == pid_) {
+      selected = &info;
+    }
+    if (selected) break;
+  }
+
+  if (!selected) {
+    if (!serial_.empty()) {
+      TOOLS_WARN_EVERY(1s, "Not found camera {}!", serial_);
+      return false;
+    }
+    selected = device_list.pDeviceInfo[0];
+  }
+
+  device_info_ = *selected;
+  has_device_info_ = true;
+  tools::logger()->info("HikRobot selected camera {}.", serial_number(device_info_));
+  return true;
+}
+
+// 多相机同步: 主相机每次曝光从 Line1 输出脉冲, 从相机在 Line0 的上升沿曝光
+void HikRobot::set_trigger()
+{
+  switch (trigger_) {
+    case Trigger::free_run:
+      set_enum_value("TriggerMode", "Off");
+      break;
+
+    case Trigger::master:
+      set_enum_value("TriggerMode", "Off");
+      set_enum_value("LineSelector", "Line1");
+      set_enum_value("LineMode", "Strobe");
+      set_bool_value("StrobeEnable", true);
+      break;
+
+    case Trigger::slave:
+      set_enum_value("TriggerMode", "On");
+      set_enum_value("TriggerSource", "Line0");
+      set_enum_value("TriggerActivation", "RisingEdge");
+      break;
   }
+}
+
+void HikRobot::close()
+{
+  if (!handle_) return;
+
+  unsigned int ret;
 
-  capture_thread_ = std::thread{[this] {
-    tools::logger()->info("HikRobot's capture thread started.");
+  ret = MV_CC_CloseDevice(handle_);
+  if (ret != MV_OK) tools::logger()->warn("MV_CC_CloseDevice failed: {:#x}", ret);
 
-    capturing_ = true;
+  ret = MV_CC_DestroyHandle(handle_);
+  if (ret != MV_OK) tools::logger()->warn("MV_CC_DestroyHandle failed: {:#x}", ret);
 
-    MV_FRAME_OUT raw;
-    MV_CC_PIXEL_CONVERT_PARAM cvt_param;
+  handle_ = nullptr;
+}
 
-    while (!capture_quit_) {
-      std::this_thread::sleep_for(1ms);
+bool HikRobot::start_grabbing()
+{
+  auto ret = MV_CC_StartGrabbing(handle_);
+  if (ret != MV_OK) {
+    TOOLS_WARN_EVERY(1s, "MV_CC_StartGrabbing failed: {:#x}", ret);
+    return false;
+  }
 
-      unsigned int ret;
-      unsigned int nMsec = 100;
+  // 看门狗从开始取流算起
+  last_frame_ns_ = std::chrono::steady_clock::now().time_since_epoch().count();
+  capturing_ = true;
+  capture_quit_ = false;
+  capture_thread_ = std::thread{[this] { capture_loop(); }};
+  return true;
+}
 
-      ret = MV_CC_GetImageBuffer(handle_, &raw, nMsec);
-      if (ret != MV_OK) {
-        tools::logger()->warn("MV_CC_GetImageBuffer failed: {:#x}", ret);
-        break;
+void HikRobot::stop_grabbing()
+{
+  capture_quit_ = true;
+  if (capture_thread_.joinable()) capture_thread_.join();
+  capturing_ = false;
+
+  if (!handle_) return;
+  auto ret = MV_CC_StopGrabbing(handle_);
+  if (ret != MV_OK) tools::logger()->warn("MV_CC_StopGrabbing failed: {:#x}", ret);
+}
+
+void HikRobot::capture_loop()
+{
+  // 多台相机时按序列号单独配置采集线程(如各绑一个核), 没有单独配置时使用公共的 capture
+  auto role = serial_.empty() ? std::string("capture") : "capture_" + serial_;
+  tools::apply_thread_policy(tools::thread_policy(role) ? role : "capture");
+  tools::logger()->info("HikRobot's capture thread started.");
+
+  // 每台相机各自一个统计, JitterMeter 只允许单个线程写入
+  auto & jitter = tools::jitter_meter(role);
+
+  MV_FRAME_OUT raw;
+
+  // MV_CC_GetImageBuffer 本身阻塞等待下一帧, 循环中不再额外休眠, 以免小ROI高帧率时限制帧率
+  while (!capture_quit_) {
+    unsigned int ret;
+    unsigned int nMsec = watchdog_.count();
+
+    ret = MV_CC_GetImageBuffer(handle_, &raw, nMsec);
+    if (ret == MV_E_NODATA && trigger_ == Trigger::slave) continue;  // 等待主相机触发
+    if (ret != MV_OK) {
+      TOOLS_WARN_EVERY(1s, "MV_CC_GetImageBuffer failed: {:#x}", ret);
+      break;
+    }
+
+    auto timestamp = std::chrono::steady_clock::now();
+    jitter.tick();
+    last_frame_ns_ = timestamp.time_since_epoch().count();
+
+    // 恢复后的第一帧: 统计掉线时长
+    if (state_ != State::streaming) {
+      if (state_ == State::recovering) {
+        auto outage_ms =
+          std::chrono::duration<double, std::milli>(timestamp - outage_begin_).count();
+        {
+          std::lock_guard<std::mutex> lock(stats_mutex_);
+          stats_.count++;
+          stats_.last_ms = outage_ms;
+          stats_.max_ms = std::max(stats_.max_ms, outage_ms);
+          stats_.total_ms += outage_ms;
+        }
+        tools::logger()->info(
+          "HikRobot recovered after {:.0f} ms ({} attempts).", outage_ms, attempts_.load());
       }
+      state_ = State::streaming;
+      attempts_ = 0;
+    }
+
+    const auto & frame_info = raw.stFrameInfo;
+    cv::Mat bayer(frame_info.nHeight, frame_info.nWidth, CV_8U, raw.pBufAddr);
+    auto code = cvt_code(frame_info.enPixelType);
+
+    // 原始Bayer数据交给钩子(如录制), 钩子内部只拷贝不阻塞
+    {
+      std::lock_guard<std::mutex> lock(raw_hook_mutex_);
+      if (raw_hook_)
+        raw_hook_(
+          {static_cast<const uint8_t *>(raw.pBufAddr), frame_info.nFrameLen,
+           static_cast<int>(frame_info.nWidth), static_cast<int>(frame_info.nHeight), code,
+           frame_info.nFrameNum, timestamp, offset_, binning_});
+    }
 
-      auto timestamp = std::chrono::steady_clock::now();
-      cv::Mat img(cv::Size(raw.stFrameInfo.nWidth, raw.stFrameInfo.nHeight), CV_8U, raw.pBufAddr);
-
-      cvt_param.nWidth = raw.stFrameInfo.nWidth;
-      cvt_param.nHeight = raw.stFrameInfo.nHeight;
-
-      cvt_param.pSrcData = raw.pBufAddr;
-      cvt_param.nSrcDataLen = raw.stFrameInfo.nFrameLen;
-      cvt_param.enSrcPixelType = raw.stFrameInfo.enPixelType;
-
-      cvt_param.pDstBuffer = img.data;
-      cvt_param.nDstBufferSize = img.total() * img.elemSize();
-      cvt_param.enDstPixelType = PixelType_Gvsp_BGR8_Packed;
-
-      // ret = MV_CC_ConvertPixelType(handle_, &cvt_param);
-      const auto & frame_info = raw.stFrameInfo;
-      auto pixel_type = frame_info.enPixelType;
-      cv::Mat dst_image;
-      const static std::unordered_map<MvGvspPixelType, cv::ColorConversionCodes> type_map = {
-        {PixelType_Gvsp_BayerGR8, cv::COLOR_BayerGR2RGB},
-        {PixelType_Gvsp_BayerRG8, cv::COLOR_BayerRG2RGB},
-        {PixelType_Gvsp_BayerGB8, cv::COLOR_BayerGB2RGB},
-        {PixelType_Gvsp_BayerBG8, cv::COLOR_BayerBG2RGB}};
-      cv::cvtColor(img, dst_image, type_map.at(pixel_type));
-      img = dst_image;
-
-      queue_.push({img, timestamp});
-
-      ret = MV_CC_FreeImageBuffer(handle_, &raw);
-      if (ret != MV_OK) {
-        tools::logger()->warn("MV_CC_FreeImageBuffer failed: {:#x}", ret);
-        break;
+    if (code < 0) {
+      TOOLS_WARN_EVERY(
+        1s, "Unsupported pixel type: {:#x}", static_cast<unsigned int>(frame_info.enPixelType));
+      MV_CC_FreeImageBuffer(handle_, &raw);
+      continue;
+    }
+
+    // 测试各转换实现需要数十毫秒, 会触发看门狗, 因此只拷贝一帧交给守护线程, 选定前用OpenCV转换
+    if (!converter_ && converter_selected_) {
+      std::lock_guard<std::mutex> lock(converter_mutex_);
+      converter_ = std::move(selected_converter_);
+      convert_ms_total_ = 0;
+      convert_count_ = 0;
+    } else if (!converter_ && !sample_sent_) {
+      {
+        std::lock_guard<std::mutex> lock(converter_mutex_);
+        bayer_sample_ = bayer.clone();
+        sample_cvt_code_ = code;
       }
+      sample_sent_ = true;
+      sample_pending_ = true;
+      wake_daemon();
     }
 
-    capturing_ = false;
-    tools::logger()->info("HikRobot's capture thread stopped.");
-  }};
+    // 转换结果写入池中的缓冲区, 下游释放后循环复用
+    auto & converter = converter_ ? *converter_ : *fallback_converter_;
+    auto img = pool_.acquire(bayer.rows, bayer.cols, CV_8UC3);
+    auto convert_begin = std::chrono::steady_clock::now();
+    if (!converter.convert(bayer, code, img)) {
+      TOOLS_WARN_EVERY(
+        1s, "Bayer conversion \"{}\" failed, fall back to opencv.", converter.name());
+      fallback_converter_->convert(bayer, code, img);
+    }
+    convert_ms_total_ +=
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - convert_begin)
+        .count();
+    convert_count_++;
+
+    CameraFrame frame;
+    frame.img = img;
+    frame.timestamp = timestamp;
+    frame.device_timestamp =
+      (uint64_t(frame_info.nDevTimeStampHigh) << 32) | frame_info.nDevTimeStampLow;
+    frame.frame_num = frame_info.nFrameNum;
+    frame.exposure_us = frame_info.fExposureTime;
+    frame.gain = frame_info.fGain;
+    frame.offset = offset_;
+    frame.binning = binning_;
+    queue_.push(frame);
+
+    if (metering_request_.exchange(false)) {
+      std::lock_guard<std::mutex> lock(metering_mutex_);
+      metering_frame_ = frame;
+    }
+
+    ret = MV_CC_FreeImageBuffer(handle_, &raw);
+    if (ret != MV_OK) {
+      TOOLS_WARN_EVERY(1s, "MV_CC_FreeImageBuffer failed: {:#x}", ret);
+      break;
+    }
+  }
+
+  capturing_ = false;
+  wake_daemon();
+  tools::logger()->info("HikRobot's capture thread stopped.");
 }
 
-void HikRobot::capture_stop()
+std::unique_ptr<BayerConverter> HikRobot::make_converter(BayerBackend backend)
 {
-  capture_quit_ = true;
-  if (capture_thread_.joinable()) capture_thread_.join();
+  switch (backend) {
+    case BayerBackend::sdk:
+      return std::make_unique<SdkConverter>(handle_);
+    case BayerBackend::bilinear:
+      return make_bilinear_converter();
+    default:
+      return make_opencv_converter();
+  }
+}
+
+// 在守护线程上测试采集线程交来的样本帧, 采集线程不等待, 看门狗照常计时
+void HikRobot::select_converter()
+{
+  cv::Mat sample;
+  int cvt_code;
+  {
+    std::lock_guard<std::mutex> lock(converter_mutex_);
+    sample = std::move(bayer_sample_);
+    cvt_code = sample_cvt_code_;
+  }
+  sample_pending_ = false;
+
+  std::vector<std::unique_ptr<BayerConverter>> candidates;
+  candidates.push_back(make_converter(BayerBackend::sdk));
+  candidates.push_back(make_converter(BayerBackend::opencv));
+  candidates.push_back(make_converter(BayerBackend::bilinear));
+  auto selected = select_fastest(std::move(candidates), sample, cvt_code);
+
+  std::lock_guard<std::mutex> lock(converter_mutex_);
+  selected_converter_ = std::move(selected);
+  converter_selected_ = true;
+}
+
+void __stdcall HikRobot::on_exception(unsigned int type, void * user)
+{
+  auto self = static_cast<HikRobot *>(user);
+  if (type == MV_EXCEPTION_DEV_DISCONNECT) self->disconnected_ = true;
+  self->wake_daemon();
+}
 
+void HikRobot::set_float_value(const std::string & name, double value)
+{
   unsigned int ret;
 
-  ret = MV_CC_StopGrabbing(handle_);
+  ret = MV_CC_SetFloatValue(handle_, name.c_str(), value);
+
   if (ret != MV_OK) {
-    tools::logger()->warn("MV_CC_StopGrabbing failed: {:#x}", ret);
+    tools::logger()->warn("MV_CC_SetFloatValue(\"{}\", {}) failed: {:#x}", name, value, ret);
     return;
   }
+}
+
+void HikRobot::set_enum_value(const std::string & name, unsigned int value)
+{
+  unsigned int ret;
+
+  ret = MV_CC_SetEnumValue(handle_, name.c_str(), value);
 
-  ret = MV_CC_CloseDevice(handle_);
   if (ret != MV_OK) {
-    tools::logger()->warn("MV_CC_CloseDevice failed: {:#x}", ret);
+    tools::logger()->warn("MV_CC_SetEnumValue(\"{}\", {}) failed: {:#x}", name, value, ret);
     return;
   }
+}
+
+void HikRobot::set_enum_value(const std::string & name, const std::string & value)
+{
+  unsigned int ret;
+
+  ret = MV_CC_SetEnumValueByString(handle_, name.c_str(), value.c_str());
 
-  ret = MV_CC_DestroyHandle(handle_);
   if (ret != MV_OK) {
-    tools::logger()->warn("MV_CC_DestroyHandle failed: {:#x}", ret);
+    tools::logger()->warn("MV_CC_SetEnumValueByString(\"{}\", {}) failed: {:#x}", name, value, ret);
     return;
   }
 }
 
-void HikRobot::set_float_value(const std::string & name, double value)
+void HikRobot::set_bool_value(const std::string & name, bool value)
 {
   unsigned int ret;
 
-  ret = MV_CC_SetFloatValue(handle_, name.c_str(), value);
+  ret = MV_CC_SetBoolValue(handle_, name.c_str(), value);
 
   if (ret != MV_OK) {
-    tools::logger()->warn("MV_CC_SetFloatValue(\"{}\", {}) failed: {:#x}", name, value, ret);
+    tools::logger()->warn("MV_CC_SetBoolValue(\"{}\", {}) failed: {:#x}", name, value, ret);
     return;
   }
 }
 
-void HikRobot::set_enum_value(const std::string & name, unsigned int value)
+bool HikRobot::set_int_value(const std::string & name, int64_t value)
 {
   unsigned int ret;
 
-  ret = MV_CC_SetEnumValue(handle_, name.c_str(), value);
+  ret = MV_CC_SetIntValueEx(handle_, name.c_str(), value);
 
   if (ret != MV_OK) {
-    tools::logger()->warn("MV_CC_SetEnumValue(\"{}\", {}) failed: {:#x}", name, value, ret);
-    return;
+    tools::logger()->warn("MV_CC_SetIntValueEx(\"{}\", {}) failed: {:#x}", name, value, ret);
+    return false;
   }
+  return true;
+}
+
+MVCC_INTVALUE_EX HikRobot::get_int_value(const std::string & name)
+{
+  MVCC_INTVALUE_EX value{};
+
+  auto ret = MV_CC_GetIntValueEx(handle_, name.c_str(), &value);
+
+  if (ret != MV_OK) tools::logger()->warn("MV_CC_GetIntValueEx(\"{}\") failed: {:#x}", name, ret);
+  return value;
 }
 
 void HikRobot::set_vid_pid(const std::string & vid_pid)
@@ -229,7 +804,31 @@ void HikRobot::reset_usb() const
   if (vid_ == -1 || pid_ == -1) return;
 
   // https://github.com/ralight/usb-reset/blob/master/usb-reset.c
-  auto handle = libusb_open_device_with_vid_pid(NULL, vid_, pid_);
+  // 多台同型号相机时按序列号找到对应的设备, 避免复位到其他相机
+  libusb_device_handle * handle = nullptr;
+  if (serial_.empty()) {
+    handle = libusb_open_device_with_vid_pid(NULL, vid_, pid_);
+  } else {
+    libusb_device ** devices;
+    auto count = libusb_get_device_list(NULL, &devices);
+    for (ssize_t i = 0; i < count && !handle; i++) {
+      libusb_device_descriptor desc;
+      if (libusb_get_device_descriptor(devices[i], &desc) != 0) continue;
+      if (desc.idVendor != vid_ || desc.idProduct != pid_ || desc.iSerialNumber == 0) continue;
+
+      libusb_device_handle * candidate;
+      if (libusb_open(devices[i], &candidate) != 0) continue;
+      unsigned char serial[64] = {};
+      auto len = libusb_get_string_descriptor_ascii(
+        candidate, desc.iSerialNumber, serial, sizeof(serial) - 1);
+      if (len > 0 && serial_ == reinterpret_cast<const char *>(serial))
+        handle = candidate;
+      else
+        libusb_close(candidate);
+    }
+    if (count >= 0) libusb_free_device_list(devices, 1);
+  }
+
   if (!handle) {
     tools::logger()->warn("Unable to open usb!");
     return;
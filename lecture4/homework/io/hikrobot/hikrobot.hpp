@@ -3,12 +3,17 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <thread>
 
 #include "MvCameraControl.h"
+#include "io/bayer.hpp"
 #include "io/camera.hpp"
+#include "io/exposure_controller.hpp"
+#include "tools/frame_pool.hpp"
 #include "tools/thread_safe_queue.hpp"
 
 namespace io
@@ -16,36 +21,137 @@ namespace io
 class HikRobot : public CameraBase
 {
 public:
-  HikRobot(double exposure_ms, double gain, const std::string & vid_pid);
+  // 掉线统计, 掉线时长从最后一帧算到恢复后的第一帧
+  struct OutageStats
+  {
+    uint64_t count = 0;
+    double last_ms = 0;
+    double max_ms = 0;
+    double total_ms = 0;
+  };
+
+  explicit HikRobot(const CameraConfig & config);
   ~HikRobot() override;
   void read(cv::Mat & img, std::chrono::steady_clock::time_point & timestamp) override;
+  ReadStatus read_for(CameraFrame & frame, std::chrono::milliseconds timeout) override;
+  void set_raw_hook(RawFrameHook hook) override;
+  void set_metering_roi(const cv::Rect & roi) override;
+  void set_sensor_roi(const cv::Rect & roi, int binning) override;
+
+  OutageStats outages() const;
 
 private:
-  struct CameraData
+  // connecting: 尚未出过图; streaming: 正常出图; recovering: 掉线后恢复中
+  enum class State
   {
-    cv::Mat img;
-    std::chrono::steady_clock::time_point timestamp;
+    connecting,
+    streaming,
+    recovering
   };
 
+  static constexpr double FRAME_RATE = 150;  // 不限帧率时看门狗按此估计
+
   double exposure_us_;
   double gain_;
+  const std::string serial_;
+  const Trigger trigger_;
+  const double frame_rate_;
+  const BayerBackend bayer_backend_;
+  const std::chrono::milliseconds watchdog_;  // 超过该时长没有新帧即判定掉线
 
   std::thread daemon_thread_;
   std::atomic<bool> daemon_quit_;
+  std::mutex daemon_mutex_;
+  std::condition_variable daemon_condition_;  // 掉线回调或采集线程退出时唤醒守护线程
 
   void * handle_;
   std::thread capture_thread_;
   std::atomic<bool> capturing_;
   std::atomic<bool> capture_quit_;
-  tools::ThreadSafeQueue<CameraData> queue_;
+  tools::ThreadSafeQueue<CameraFrame, true> queue_;  // 只保留最新一帧, 被覆盖的帧计入 dropped
+  tools::FramePool pool_;                             // 转换后的BGR图像, 只在采集线程上取用
+
+  // Bayer转换, 选定后重连也沿用; 只在采集线程上访问
+  // automatic 时先用 fallback_converter_, 采集线程拷贝第一帧交给守护线程测试, 选定后再换上
+  std::unique_ptr<BayerConverter> converter_;
+  std::unique_ptr<BayerConverter> fallback_converter_;
+  double convert_ms_total_;
+  uint64_t convert_count_;
+  bool sample_sent_;
+
+  // 采集线程与守护线程之间交接样本帧与选定的转换
+  std::mutex converter_mutex_;
+  cv::Mat bayer_sample_;
+  int sample_cvt_code_;
+  std::atomic<bool> sample_pending_;
+  std::unique_ptr<BayerConverter> selected_converter_;
+  std::atomic<bool> converter_selected_;
+
+  std::atomic<State> state_;
+  std::atomic<bool> disconnected_;      // SDK报告设备断开
+  std::atomic<int64_t> last_frame_ns_;  // 最后一帧(或开始取流)的时刻, steady_clock 计数
+  std::atomic<int> attempts_;           // 本次掉线以来的恢复尝试次数
+  std::chrono::steady_clock::time_point outage_begin_;
+
+  // 首次枚举到的设备信息, 重连时直接用它创建句柄, 省去枚举
+  bool has_device_info_;
+  MV_CC_DEVICE_INFO device_info_;
+
+  mutable std::mutex stats_mutex_;
+  OutageStats stats_;
+
+  // 只在读取线程上访问, 用于按帧号计算丢帧数
+  bool has_last_frame_;
+  uint64_t last_frame_num_;
+
+  std::mutex raw_hook_mutex_;
+  RawFrameHook raw_hook_;
+
+  // 自动曝光在守护线程上按 rate_hz 运行, 采集线程只在被请求时交出一帧, 不做统计
+  const ExposureControl exposure_control_;
+  ExposureController exposure_controller_;
+  std::chrono::steady_clock::time_point next_exposure_update_;
+  std::atomic<bool> metering_request_;
+  std::mutex metering_mutex_;
+  CameraFrame metering_frame_;
+  cv::Rect metering_roi_;
+
+  // 传感器端ROI: 请求的窗口在守护线程上停流后设置, 采集线程只读取已生效的值
+  std::mutex window_mutex_;
+  cv::Rect requested_roi_;
+  int requested_binning_;
+  std::atomic<bool> window_changed_;
+  cv::Point offset_;  // 已生效的窗口, 全分辨率坐标
+  int binning_;
 
   int vid_, pid_;
 
-  void capture_start();
-  void capture_stop();
+  void daemon_loop();
+  bool need_recovery() const;
+  void recover();
+  void wake_daemon();
+  void update_exposure();
+
+  bool open(bool enumerate);
+  bool select_device(const MV_CC_DEVICE_INFO_LIST & device_list);
+  void set_trigger();
+  cv::Size set_window();
+  void apply_window();
+  void close();
+  bool start_grabbing();
+  void stop_grabbing();
+  void capture_loop();
+  std::unique_ptr<BayerConverter> make_converter(BayerBackend backend);
+  void select_converter();
+
+  static void __stdcall on_exception(unsigned int type, void * user);
 
   void set_float_value(const std::string & name, double value);
   void set_enum_value(const std::string & name, unsigned int value);
+  void set_enum_value(const std::string & name, const std::string & value);
+  void set_bool_value(const std::string & name, bool value);
+  bool set_int_value(const std::string & name, int64_t value);
+  MVCC_INTVALUE_EX get_int_value(const std::string & name);
 
   void set_vid_pid(const std::string & vid_pid);
   void reset_usb() const;
@@ -53,4 +159,4 @@ private:
 
 }  // namespace io
 
-#endif  // IO__HIKROBOT_HPP
\ No newline at end of file
+#endif  // IO__HIKROBOT_HPP
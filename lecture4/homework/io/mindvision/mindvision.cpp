@@ -0,0 +1,176 @@
+#include "mindvision.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "tools/logger.hpp"
+#include "tools/thread_config.hpp"
+
+using namespace std::chrono_literals;
+
+namespace io
+{
+MindVision::MindVision(const CameraConfig & config)
+: serial_(config.serial),
+  watchdog_(std::max<int>(30, 5 * 1000 / (config.frame_rate > 0 ? config.frame_rate : 150))),
+  handle_(0),
+  quit_(false),
+  queue_(1),
+  pool_(8),
+  last_frame_ns_(0),
+  has_last_frame_(false),
+  last_frame_num_(0)
+{
+  open(config);
+
+  capture_thread_ = std::thread{[this] { capture_loop(); }};
+}
+
+MindVision::~MindVision()
+{
+  quit_ = true;
+  if (capture_thread_.joinable()) capture_thread_.join();
+
+  CameraUnInit(handle_);
+  tools::logger()->info("MindVision destructed.");
+}
+
+void MindVision::read(cv::Mat & img, std::chrono::steady_clock::time_point & timestamp)
+{
+  CameraFrame frame;
+  while (read_for(frame, std::chrono::seconds(1)) != ReadStatus::ok) continue;
+
+  img = frame.img;
+  timestamp = frame.timestamp;
+}
+
+ReadStatus MindVision::read_for(CameraFrame & frame, std::chrono::milliseconds timeout)
+{
+  if (!queue_.pop_for(frame, timeout)) {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    auto stalled = now - std::chrono::steady_clock::duration(last_frame_ns_) > watchdog_;
+    return stalled ? ReadStatus::reconnecting : ReadStatus::timeout;
+  }
+
+  // 帧号由采集线程按SDK的丢帧统计推算, 不连续即为丢帧
+  frame.dropped = has_last_frame_ && frame.frame_num > last_frame_num_
+                    ? frame.frame_num - last_frame_num_ - 1
+                    : 0;
+  has_last_frame_ = true;
+  last_frame_num_ = frame.frame_num;
+  return ReadStatus::ok;
+}
+
+void MindVision::set_raw_hook(RawFrameHook hook)
+{
+  std::lock_guard<std::mutex> lock(raw_hook_mutex_);
+  raw_hook_ = std::move(hook);
+}
+
+// 指定了序列号时只打开该相机, 否则打开第一台
+void MindVision::open(const CameraConfig & config)
+{
+  CameraSdkInit(1);
+
+  tSdkCameraDevInfo devices[8];
+  int count = 8;
+  auto status = CameraEnumerateDevice(devices, &count);
+  if (status != CAMERA_STATUS_SUCCESS || count == 0) throw std::runtime_error("Not found camera!");
+
+  auto selected = &devices[0];
+  if (!serial_.empty()) {
+    selected = nullptr;
+    for (int i = 0; i < count; i++)
+      if (serial_ == devices[i].acSn) selected = &devices[i];
+    if (!selected) throw std::runtime_error("Not found camera " + serial_ + "!");
+  }
+
+  status = CameraInit(selected, -1, -1, &handle_);
+  if (status != CAMERA_STATUS_SUCCESS)
+    throw std::runtime_error("CameraInit failed: " + std::to_string(status));
+  tools::logger()->info("MindVision opened camera {}.", selected->acSn);
+
+  CameraSetTriggerMode(handle_, config.trigger == Trigger::slave ? 2 : 0);  // 2: 硬件触发
+  if (config.trigger == Trigger::master)
+    tools::logger()->warn("MindVision does not output a strobe, running as free run.");
+
+  CameraSetAeState(handle_, FALSE);
+  CameraSetExposureTime(handle_, config.exposure_ms * 1e3);
+  CameraSetAnalogGainX(handle_, std::pow(10, config.gain / 20));  // dB 转为倍数
+  CameraSetIspOutFormat(handle_, CAMERA_MEDIA_TYPE_BGR8);
+  CameraPlay(handle_);
+
+  // 与 HikRobot 相同: 看门狗从开始取流算起, 启动时尚未出图不应被当作掉线
+  last_frame_ns_ = std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+void MindVision::capture_loop()
+{
+  // 与 HikRobot 相同: 优先使用按序列号单独配置的采集线程
+  auto role = serial_.empty() ? std::string("capture") : "capture_" + serial_;
+  tools::apply_thread_policy(tools::thread_policy(role) ? role : "capture");
+  tools::logger()->info("MindVision's capture thread started.");
+
+  auto & jitter = tools::jitter_meter(role);
+
+  const static std::unordered_map<UINT, cv::ColorConversionCodes> type_map = {
+    {CAMERA_MEDIA_TYPE_BAYGR8, cv::COLOR_BayerGR2RGB},
+    {CAMERA_MEDIA_TYPE_BAYRG8, cv::COLOR_BayerRG2RGB},
+    {CAMERA_MEDIA_TYPE_BAYGB8, cv::COLOR_BayerGB2RGB},
+    {CAMERA_MEDIA_TYPE_BAYBG8, cv::COLOR_BayerBG2RGB}};
+
+  // SDK不提供帧号, 用已采集数与丢帧数之和代替, 使 dropped 与 HikRobot 含义一致
+  tSdkFrameStatistic statistic;
+  uint64_t frame_num = 0;
+
+  while (!quit_) {
+    tSdkFrameHead head;
+    BYTE * raw;
+    auto status = CameraGetImageBuffer(handle_, &head, &raw, watchdog_.count());
+    if (status != CAMERA_STATUS_SUCCESS) {
+      if (status != CAMERA_STATUS_TIME_OUT)
+        TOOLS_WARN_EVERY(1s, "CameraGetImageBuffer failed: {}", status);
+      continue;
+    }
+
+    auto timestamp = std::chrono::steady_clock::now();
+    jitter.tick();
+    last_frame_ns_ = timestamp.time_since_epoch().count();
+
+    if (CameraGetFrameStatistic(handle_, &statistic) == CAMERA_STATUS_SUCCESS)
+      frame_num = std::max<uint64_t>(frame_num + 1, statistic.iCapture + statistic.iLost);
+    else
+      frame_num++;
+
+    // 原始Bayer数据交给钩子(如录制), 钩子内部只拷贝不阻塞
+    {
+      std::lock_guard<std::mutex> lock(raw_hook_mutex_);
+      if (raw_hook_) {
+        auto it = type_map.find(head.uiMediaType);
+        raw_hook_(
+          {raw, head.uBytes, head.iWidth, head.iHeight,
+           it == type_map.end() ? -1 : static_cast<int>(it->second), frame_num, timestamp});
+      }
+    }
+
+    // ISP输出写入池中的缓冲区, 下游释放后循环复用
+    auto img = pool_.acquire(head.iHeight, head.iWidth, CV_8UC3);
+    CameraImageProcess(handle_, raw, img.data, &head);
+    CameraReleaseImageBuffer(handle_, raw);
+
+    CameraFrame frame;
+    frame.img = img;
+    frame.timestamp = timestamp;
+    frame.device_timestamp = head.uiTimeStamp;  // 0.1ms
+    frame.frame_num = frame_num;
+    frame.exposure_us = head.uiExpTime;
+    frame.gain = 20 * std::log10(std::max(head.fAnalogGain, 1e-3f));
+    queue_.push(frame);
+  }
+
+  CameraPause(handle_);
+  tools::logger()->info("MindVision's capture thread stopped.");
+}
+
+}  // namespace io
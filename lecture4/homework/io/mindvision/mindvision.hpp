@@ -0,0 +1,54 @@
+#ifndef IO__MINDVISION_HPP
+#define IO__MINDVISION_HPP
+
+#include <CameraApi.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+
+#include "io/camera.hpp"
+#include "tools/frame_pool.hpp"
+#include "tools/thread_safe_queue.hpp"
+
+namespace io
+{
+// 迈德威视相机, 与 HikRobot 相同的接口: 独立采集线程, ISP输出写入缓冲池, 读取到的图像不会被下一帧覆盖
+// 掉线重连由SDK内部完成, 期间 read_for 返回 reconnecting
+class MindVision : public CameraBase
+{
+public:
+  explicit MindVision(const CameraConfig & config);
+  ~MindVision() override;
+  void read(cv::Mat & img, std::chrono::steady_clock::time_point & timestamp) override;
+  ReadStatus read_for(CameraFrame & frame, std::chrono::milliseconds timeout) override;
+  void set_raw_hook(RawFrameHook hook) override;
+
+private:
+  const std::string serial_;
+  const std::chrono::milliseconds watchdog_;  // 超过该时长没有新帧即认为在重连
+
+  CameraHandle handle_;
+  std::thread capture_thread_;
+  std::atomic<bool> quit_;
+  tools::ThreadSafeQueue<CameraFrame, true> queue_;  // 只保留最新一帧, 被覆盖的帧计入 dropped
+  tools::FramePool pool_;
+  std::atomic<int64_t> last_frame_ns_;
+
+  // 只在读取线程上访问, 用于按帧号计算丢帧数
+  bool has_last_frame_;
+  uint64_t last_frame_num_;
+
+  std::mutex raw_hook_mutex_;
+  RawFrameHook raw_hook_;
+
+  void open(const CameraConfig & config);
+  void capture_loop();
+};
+
+}  // namespace io
+
+#endif  // IO__MINDVISION_HPP
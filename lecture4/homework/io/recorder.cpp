@@ -0,0 +1,228 @@
+#include "recorder.hpp"
+
+#include <fcntl.h>     // open, posix_fallocate, posix_fadvise, sync_file_range
+#include <sys/mman.h>  // mmap, munmap
+#include <unistd.h>    // close, unlink
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include "tools/logger.hpp"
+#include "tools/thread_config.hpp"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+// 每写满16MB用 sync_file_range 发起一次回写(不等待), 避免脏页堆积后被内核集中回写而卡顿
+// msync(MS_ASYNC) 自 Linux 2.6.19 起不发起回写, 不能替代
+constexpr size_t SYNC_STEP = 16 << 20;
+
+size_t align_up(size_t value, size_t align) { return (value + align - 1) / align * align; }
+}  // namespace
+
+namespace io
+{
+std::string segment_name(uint64_t index) { return fmt::format("{:06d}.seg", index); }
+
+Recorder::Recorder(
+  const std::string & dir, size_t disk_budget_mb, size_t segment_mb, size_t slot_num,
+  size_t frame_bytes)
+: dir_(dir),
+  segment_size_(segment_mb << 20),
+  max_segments_(std::max<size_t>(2, disk_budget_mb / segment_mb)),
+  slots_(slot_num),
+  head_(0),
+  tail_(0),
+  written_(0),
+  dropped_(0),
+  quit_(false),
+  next_index_(0),
+  fd_(-1),
+  map_(nullptr),
+  offset_(0),
+  synced_(0)
+{
+  // 预先触碰全部槽位内存, 避免采集线程上首次写入时缺页
+  for (auto & slot : slots_) slot.data.resize(frame_bytes);
+
+  // 接着已有的段继续编号, 已有的段同样计入磁盘预算
+  std::filesystem::create_directories(dir_);
+  std::vector<uint64_t> existing;
+  for (const auto & entry : std::filesystem::directory_iterator(dir_)) {
+    if (entry.path().extension() != ".seg") continue;
+    try {
+      existing.emplace_back(std::stoull(entry.path().stem().string()));
+    } catch (const std::exception &) {
+    }
+  }
+  std::sort(existing.begin(), existing.end());
+  segments_.assign(existing.begin(), existing.end());
+  if (!existing.empty()) next_index_ = existing.back() + 1;
+
+  writer_thread_ = std::thread{[this] {
+    tools::apply_thread_policy("recorder");
+    write_loop();
+  }};
+  tools::logger()->info(
+    "Recorder started: {}, {} MB x {} segments.", dir_, segment_mb, max_segments_);
+}
+
+Recorder::~Recorder()
+{
+  quit_ = true;
+  condition_.notify_one();
+  if (writer_thread_.joinable()) writer_thread_.join();
+  tools::logger()->info("Recorder stopped: {} written, {} dropped.", written_, dropped_);
+}
+
+void Recorder::push(const RawFrame & frame)
+{
+  auto head = head_.load(std::memory_order_relaxed);
+  auto tail = tail_.load(std::memory_order_acquire);
+
+  if (head - tail >= slots_.size()) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  auto & slot = slots_[head % slots_.size()];
+  slot.header.magic = FRAME_MAGIC;
+  slot.header.width = frame.width;
+  slot.header.height = frame.height;
+  slot.header.cvt_code = frame.cvt_code;
+  slot.header.size = frame.size;
+  slot.header.frame_num = frame.frame_num;
+  slot.header.timestamp_ns =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(frame.timestamp.time_since_epoch())
+      .count();
+  slot.header.offset_x = frame.offset.x;
+  slot.header.offset_y = frame.offset.y;
+  slot.header.binning = frame.binning;
+  slot.header.reserved = 0;
+  if (slot.data.size() < frame.size) slot.data.resize(frame.size);
+  std::memcpy(slot.data.data(), frame.data, frame.size);
+
+  head_.store(head + 1, std::memory_order_release);
+  condition_.notify_one();
+}
+
+RawFrameHook Recorder::hook()
+{
+  return [this](const RawFrame & frame) { push(frame); };
+}
+
+void Recorder::write_loop()
+{
+  while (true) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    auto head = head_.load(std::memory_order_acquire);
+
+    if (tail == head) {
+      if (quit_) break;
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait_for(lock, 10ms);
+      continue;
+    }
+
+    for (; tail != head; tail++) {
+      write(slots_[tail % slots_.size()]);
+      tail_.store(tail + 1, std::memory_order_release);
+    }
+  }
+
+  close_segment();
+}
+
+void Recorder::write(const Slot & slot)
+{
+  auto record_size = align_up(sizeof(FrameHeader) + slot.header.size, RECORD_ALIGN);
+  if (record_size > segment_size_ - SEGMENT_HEADER_SIZE) {
+    TOOLS_WARN_EVERY(1s, "Recorder: frame of {} bytes exceeds segment size.", slot.header.size);
+    return;
+  }
+
+  if (map_ && offset_ + record_size > segment_size_) close_segment();
+  if (!map_ && !open_segment()) return;
+
+  std::memcpy(map_ + offset_, &slot.header, sizeof(FrameHeader));
+  std::memcpy(map_ + offset_ + sizeof(FrameHeader), slot.data.data(), slot.header.size);
+  offset_ += record_size;
+
+  // 数据写完后再更新段头, 中途断电时读取端只会看到完整的帧
+  auto header = reinterpret_cast<SegmentHeader *>(map_);
+  header->frame_count++;
+  header->bytes_used = offset_;
+  written_++;
+
+  if (offset_ - synced_ >= SYNC_STEP) {
+    ::sync_file_range(fd_, synced_, offset_ - synced_, SYNC_FILE_RANGE_WRITE);
+    synced_ = offset_ / 4096 * 4096;
+  }
+}
+
+bool Recorder::open_segment()
+{
+  while (segments_.size() >= max_segments_) {
+    std::filesystem::remove(std::filesystem::path(dir_) / segment_name(segments_.front()));
+    segments_.pop_front();
+  }
+
+  auto path = (std::filesystem::path(dir_) / segment_name(next_index_)).string();
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    TOOLS_WARN_EVERY(1s, "Recorder: unable to open {}.", path);
+    return false;
+  }
+
+  // 一次性分配磁盘空间, 写入时不再触发块分配
+  if (::posix_fallocate(fd_, 0, segment_size_) != 0) {
+    TOOLS_WARN_EVERY(1s, "Recorder: unable to allocate {} bytes for {}.", segment_size_, path);
+    ::close(fd_);
+    ::unlink(path.c_str());
+    fd_ = -1;
+    return false;
+  }
+
+  auto map = ::mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (map == MAP_FAILED) {
+    TOOLS_WARN_EVERY(1s, "Recorder: unable to mmap {}.", path);
+    ::close(fd_);
+    ::unlink(path.c_str());
+    fd_ = -1;
+    return false;
+  }
+  map_ = static_cast<uint8_t *>(map);
+  ::madvise(map_, segment_size_, MADV_SEQUENTIAL);
+
+  SegmentHeader header{};
+  std::memcpy(header.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+  header.version = SEGMENT_VERSION;
+  header.header_size = SEGMENT_HEADER_SIZE;
+  header.frame_count = 0;
+  header.bytes_used = SEGMENT_HEADER_SIZE;
+  std::memcpy(map_, &header, sizeof(header));
+
+  offset_ = SEGMENT_HEADER_SIZE;
+  synced_ = 0;
+  segments_.emplace_back(next_index_++);
+  return true;
+}
+
+void Recorder::close_segment()
+{
+  if (!map_) return;
+
+  // 等剩余的脏页(包括反复改写的段头)写完, 之后 DONTNEED 才能真正释放页缓存
+  ::sync_file_range(
+    fd_, 0, offset_, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+  ::munmap(map_, segment_size_);
+  ::posix_fadvise(fd_, 0, segment_size_, POSIX_FADV_DONTNEED);  // 录像不再读取, 释放页缓存
+  ::close(fd_);
+
+  map_ = nullptr;
+  fd_ = -1;
+}
+
+}  // namespace io
@@ -0,0 +1,115 @@
+#ifndef IO__RECORDER_HPP
+#define IO__RECORDER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "io/camera.hpp"
+
+namespace io
+{
+// 录制文件格式: 目录下按序号命名的段文件 000000.seg, 000001.seg, ...
+// 每个段文件预分配为固定大小, 开头是SegmentHeader, 之后是连续的帧记录
+// 每条帧记录为 FrameHeader + 原始数据, 按RECORD_ALIGN对齐
+constexpr char SEGMENT_MAGIC[8] = {'S', 'P', 'R', 'A', 'W', 'S', 'E', 'G'};
+constexpr uint32_t SEGMENT_VERSION = 2;  // 2: FrameHeader 增加传感器窗口
+constexpr uint32_t FRAME_MAGIC = 0x4d415246;  // "FRAM"
+constexpr size_t SEGMENT_HEADER_SIZE = 4096;
+constexpr size_t RECORD_ALIGN = 64;
+
+struct SegmentHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint64_t frame_count;
+  uint64_t bytes_used;  // 含段头, 读取时以此为准, 可安全读取写到一半的段
+};
+
+struct FrameHeader
+{
+  uint32_t magic;
+  int32_t width;
+  int32_t height;
+  int32_t cvt_code;
+  uint64_t size;
+  uint64_t frame_num;
+  int64_t timestamp_ns;  // steady_clock
+  int32_t offset_x;      // 传感器窗口, 全分辨率坐标
+  int32_t offset_y;
+  int32_t binning;
+  int32_t reserved;
+};
+
+// 版本1的帧头不含传感器窗口, 只有 timestamp_ns 及之前的字段
+constexpr size_t FRAME_HEADER_SIZE_V1 = offsetof(FrameHeader, offset_x);
+
+std::string segment_name(uint64_t index);
+
+// 原始帧录制器
+// push 在采集线程上调用: 只把数据拷进预分配的槽位, 槽位用尽时丢帧计数, 从不阻塞
+// 后台线程把槽位写入mmap映射的段文件, 超出磁盘预算时删除最旧的段
+class Recorder
+{
+public:
+  Recorder(
+    const std::string & dir, size_t disk_budget_mb = 8192, size_t segment_mb = 256,
+    size_t slot_num = 64, size_t frame_bytes = 1440 * 1080);
+  ~Recorder();
+
+  void push(const RawFrame & frame);
+
+  // 便于直接作为相机的原始帧钩子
+  RawFrameHook hook();
+
+  uint64_t written() const { return written_; }
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  struct Slot
+  {
+    FrameHeader header;
+    std::vector<uint8_t> data;
+  };
+
+  const std::string dir_;
+  const size_t segment_size_;
+  const size_t max_segments_;
+
+  // 单生产者(采集线程)单消费者(写线程)的槽位环
+  std::vector<Slot> slots_;
+  alignas(64) std::atomic<size_t> head_;
+  alignas(64) std::atomic<size_t> tail_;
+
+  std::atomic<uint64_t> written_;
+  std::atomic<uint64_t> dropped_;
+
+  std::atomic<bool> quit_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::thread writer_thread_;
+
+  // 以下只在写线程上访问
+  std::deque<uint64_t> segments_;
+  uint64_t next_index_;
+  int fd_;
+  uint8_t * map_;
+  size_t offset_;
+  size_t synced_;
+
+  void write_loop();
+  void write(const Slot & slot);
+  bool open_segment();
+  void close_segment();
+};
+
+}  // namespace io
+
+#endif  // IO__RECORDER_HPP
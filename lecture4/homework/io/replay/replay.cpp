@@ -0,0 +1,245 @@
+#include "replay.hpp"
+
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "io/recorder.hpp"
+#include "tools/logger.hpp"
+#include "tools/thread_config.hpp"
+
+namespace io
+{
+Replay::Replay(const std::string & path, ReplayMode mode, size_t prefetch)
+: path_(path),
+  mode_(mode),
+  prefetch_(std::max<size_t>(1, prefetch)),
+  quit_(false),
+  started_(false),
+  finished_(false),
+  paused_(0),
+  dropped_(0),
+  has_last_frame_(false),
+  last_frame_num_(0)
+{
+  prefetch_thread_ = std::thread{[this] {
+    tools::apply_thread_policy("replay");
+    if (std::filesystem::is_directory(path_))
+      read_segments();
+    else
+      read_video();
+    push({cv::Mat(), std::chrono::nanoseconds(0), 0, true});
+  }};
+}
+
+Replay::~Replay()
+{
+  quit_ = true;
+  not_full_.notify_all();
+  if (prefetch_thread_.joinable()) prefetch_thread_.join();
+  tools::logger()->info("Replay destructed, {} frames dropped.", dropped_);
+}
+
+void Replay::read(cv::Mat & img, std::chrono::steady_clock::time_point & timestamp)
+{
+  CameraFrame frame;
+  while (read_for(frame, std::chrono::seconds(1)) == ReadStatus::timeout) continue;
+
+  img = frame.img;
+  timestamp = frame.timestamp;
+}
+
+ReadStatus Replay::read_for(CameraFrame & result, std::chrono::milliseconds timeout)
+{
+  if (finished_) {
+    result.img = cv::Mat();
+    return ReadStatus::end;
+  }
+
+  Frame frame;
+  if (!pop(frame, timeout)) return ReadStatus::timeout;
+  if (!started_) {
+    started_ = true;
+    start_ = std::chrono::steady_clock::now() - frame.offset;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+
+  if (mode_ == ReplayMode::realtime) {
+    // 与相机一致: 处理不过来的帧直接丢弃, 只返回最新到期的一帧
+    while (!frame.end) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (frames_.empty() || frames_.front().end) break;
+      if (start_ + frames_.front().offset > now) break;
+      frame = std::move(frames_.front());
+      frames_.pop_front();
+      not_full_.notify_one();
+      dropped_++;
+    }
+  }
+
+  if (frame.end) {
+    finished_ = true;
+    tools::logger()->info("Replay of \"{}\" finished.", path_);
+    result.img = cv::Mat();
+    return ReadStatus::end;
+  }
+
+  auto timestamp = start_ + paused_ + frame.offset;
+
+  if (mode_ == ReplayMode::realtime) {
+    std::this_thread::sleep_until(timestamp);
+  } else if (mode_ == ReplayMode::lockstep) {
+    // 不丢帧: 处理慢于录制节奏时回放时钟随之暂停
+    if (timestamp < now) {
+      paused_ += now - timestamp;
+      timestamp = now;
+    }
+    std::this_thread::sleep_until(timestamp);
+  }
+
+  // 录制时的丢帧与realtime模式下的跳帧都体现为帧号不连续
+  result.img = frame.img;
+  result.timestamp = timestamp;
+  result.frame_num = frame.frame_num;
+  result.offset = frame.sensor_offset;
+  result.binning = frame.binning;
+  result.dropped = has_last_frame_ && frame.frame_num > last_frame_num_
+                     ? frame.frame_num - last_frame_num_ - 1
+                     : 0;
+  has_last_frame_ = true;
+  last_frame_num_ = frame.frame_num;
+  return ReadStatus::ok;
+}
+
+void Replay::push(Frame && frame)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  not_full_.wait(lock, [this] { return quit_ || frames_.size() < prefetch_; });
+  if (quit_) return;
+  frames_.emplace_back(std::move(frame));
+  not_empty_.notify_one();
+}
+
+bool Replay::pop(Frame & frame, std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!not_empty_.wait_for(lock, timeout, [this] { return !frames_.empty(); })) return false;
+  frame = std::move(frames_.front());
+  frames_.pop_front();
+  not_full_.notify_one();
+  return true;
+}
+
+void Replay::read_segments()
+{
+  std::vector<std::filesystem::path> paths;
+  for (const auto & entry : std::filesystem::directory_iterator(path_))
+    if (entry.path().extension() == ".seg") paths.emplace_back(entry.path());
+  std::sort(paths.begin(), paths.end());
+
+  int64_t first_ns = -1;
+
+  for (const auto & path : paths) {
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    struct stat st;
+    auto valid = fd >= 0 && ::fstat(fd, &st) == 0;
+    if (valid) valid = static_cast<size_t>(st.st_size) >= SEGMENT_HEADER_SIZE;
+    if (!valid) {
+      tools::logger()->warn("Replay: unable to open {}.", path.string());
+      if (fd >= 0) ::close(fd);
+      continue;
+    }
+
+    auto map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+      tools::logger()->warn("Replay: unable to mmap {}.", path.string());
+      continue;
+    }
+    ::madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    auto data = static_cast<const uint8_t *>(map);
+    SegmentHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0) {
+      tools::logger()->warn("Replay: {} is not a recorder segment.", path.string());
+      ::munmap(map, st.st_size);
+      continue;
+    }
+
+    // 旧版本的帧头较短, 缺少的传感器窗口按整幅图像处理
+    auto frame_header_size = header.version >= 2 ? sizeof(FrameHeader) : FRAME_HEADER_SIZE_V1;
+    auto end = std::min<size_t>(header.bytes_used, st.st_size);
+    size_t offset = header.header_size;
+    while (!quit_ && offset + frame_header_size <= end) {
+      FrameHeader frame{};
+      frame.binning = 1;
+      std::memcpy(&frame, data + offset, frame_header_size);
+      if (frame.magic != FRAME_MAGIC || frame.size > end - offset - frame_header_size) break;
+
+      // 帧头损坏时宽高可能与数据长度不符, 不能据此越界读取映射区
+      if (
+        frame.width <= 0 || frame.height <= 0 ||
+        uint64_t(frame.width) * uint64_t(frame.height) > frame.size) {
+        tools::logger()->warn(
+          "Replay: corrupt frame {} ({}x{}, {} bytes) in {}.", frame.frame_num, frame.width,
+          frame.height, frame.size, path.string());
+        break;
+      }
+
+      // 与HikRobot的采集线程做同样的Bayer转换
+      auto pixels = const_cast<uint8_t *>(data + offset + frame_header_size);
+      cv::Mat raw(frame.height, frame.width, CV_8U, pixels);
+      cv::Mat img;
+      if (frame.cvt_code >= 0)
+        cv::cvtColor(raw, img, frame.cvt_code);
+      else
+        img = raw.clone();
+
+      if (first_ns < 0) first_ns = frame.timestamp_ns;
+      Frame record{img, std::chrono::nanoseconds(frame.timestamp_ns - first_ns), frame.frame_num};
+      record.sensor_offset = cv::Point(frame.offset_x, frame.offset_y);
+      record.binning = std::max(1, frame.binning);
+      push(std::move(record));
+
+      offset += (frame_header_size + frame.size + RECORD_ALIGN - 1) / RECORD_ALIGN * RECORD_ALIGN;
+    }
+
+    ::munmap(map, st.st_size);
+    if (quit_) return;
+  }
+}
+
+void Replay::read_video()
+{
+  cv::VideoCapture cap(path_);
+  if (!cap.isOpened()) {
+    tools::logger()->warn("Replay: unable to open \"{}\".", path_);
+    return;
+  }
+
+  auto fps = cap.get(cv::CAP_PROP_FPS);
+  if (fps <= 0) fps = 30;
+
+  for (int64_t index = 0; !quit_; index++) {
+    cv::Mat img;
+    if (!cap.read(img) || img.empty()) break;
+
+    // 部分容器不提供时间戳, 此时按帧率推算
+    auto msec = cap.get(cv::CAP_PROP_POS_MSEC);
+    auto offset = msec > 0 || index == 0
+                    ? std::chrono::duration<double, std::milli>(msec)
+                    : std::chrono::duration<double, std::milli>(index * 1e3 / fps);
+    push(
+      {img, std::chrono::duration_cast<std::chrono::nanoseconds>(offset), uint64_t(index)});
+  }
+}
+
+}  // namespace io
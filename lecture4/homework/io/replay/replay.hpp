@@ -0,0 +1,68 @@
+#ifndef IO__REPLAY_HPP
+#define IO__REPLAY_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+
+#include "io/camera.hpp"
+
+namespace io
+{
+// 回放相机: 读取 io::Recorder 录制的段目录或任意视频文件
+// 解码在预取线程上进行, read 按 ReplayMode 决定节奏; 播放结束后 read 返回空图像
+class Replay : public CameraBase
+{
+public:
+  Replay(const std::string & path, ReplayMode mode = ReplayMode::realtime, size_t prefetch = 8);
+  ~Replay() override;
+  void read(cv::Mat & img, std::chrono::steady_clock::time_point & timestamp) override;
+  ReadStatus read_for(CameraFrame & frame, std::chrono::milliseconds timeout) override;
+
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  struct Frame
+  {
+    cv::Mat img;
+    std::chrono::nanoseconds offset;  // 相对第一帧的录制时间
+    uint64_t frame_num = 0;
+    bool end = false;
+    cv::Point sensor_offset;  // 录制时的传感器窗口
+    int binning = 1;
+  };
+
+  const std::string path_;
+  const ReplayMode mode_;
+  const size_t prefetch_;
+
+  std::deque<Frame> frames_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_, not_full_;
+  std::atomic<bool> quit_;
+  std::thread prefetch_thread_;
+
+  // 以下只在调用read的线程上访问
+  bool started_;
+  bool finished_;
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::nanoseconds paused_;  // lockstep模式下处理慢于录制节奏而累计的暂停
+  std::atomic<uint64_t> dropped_;
+  bool has_last_frame_;
+  uint64_t last_frame_num_;
+
+  void push(Frame && frame);
+  bool pop(Frame & frame, std::chrono::milliseconds timeout);
+
+  void read_segments();
+  void read_video();
+};
+
+}  // namespace io
+
+#endif  // IO__REPLAY_HPP
@@ -0,0 +1,60 @@
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tools/logger.hpp"
+
+using namespace std::chrono_literals;
+
+// 测量采集线程上一次日志调用的耗时, 分别测试同步、异步与限频三种方式
+// 异步方式仍在调用线程上格式化并唤醒写线程, 均值约0.5~2us, p99达数微秒; 只有限频方式稳定低于1us
+// 因此采集线程的热循环只用 TOOLS_*_EVERY
+// 日志本身会刷屏, 建议: ./logger_benchmark [条数] > /dev/null
+int main(int argc, char ** argv)
+{
+  const int count = std::max(1, argc > 1 ? std::stoi(argv[1]) : 20000);
+
+  auto run = [count](const std::string & name, auto && log) {
+    // 每次调用的耗时先存入预分配的数组, 统计分位数, 均值会被少数长尾掩盖
+    std::vector<double> samples(count);
+    // 模拟150fps采集线程中的日志调用
+    std::thread capture_thread{[&] {
+      for (int i = 0; i < count; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        log(i);
+        auto end = std::chrono::steady_clock::now();
+        samples[i] = std::chrono::duration<double, std::nano>(end - begin).count();
+        if (i % 100 == 0) std::this_thread::sleep_for(1ms);
+      }
+    }};
+    capture_thread.join();
+
+    auto mean = std::accumulate(samples.begin(), samples.end(), 0.0) / count;
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) { return samples[std::min<size_t>(count - 1, p * count)]; };
+    fmt::print(
+      stderr, "{:<8} mean {:>8.1f} ns, p50 {:>8.1f} ns, p99 {:>9.1f} ns, max {:>10.1f} ns\n", name,
+      mean, percentile(0.5), percentile(0.99), samples.back());
+  };
+
+  auto log = [](int i) {
+    tools::logger()->warn("MV_CC_GetImageBuffer failed: {:#x}, frame {}", 0x80000007, i);
+  };
+  auto log_limited = [](int i) {
+    TOOLS_WARN_EVERY(100ms, "MV_CC_GetImageBuffer failed: {:#x}, frame {}", 0x80000007, i);
+  };
+
+  run("sync", log);
+
+  tools::set_async_logger();
+  run("async", log);
+  run("limited", log_limited);
+
+  fmt::print(stderr, "dropped {} logs\n", tools::dropped_logs());
+  return 0;
+}
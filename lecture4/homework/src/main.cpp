@@ -1,152 +1,565 @@
 #include "tasks/buff_detector.hpp"
 #include "tasks/buff_solver.hpp"
+#include "tasks/aimer.hpp"
 #include "io/camera.hpp"
+#include "io/camera_group.hpp"
+#include "io/recorder.hpp"
 #include "tools/plotter.hpp"
+#include "tools/logger.hpp"
+#include "tools/visualizer.hpp"
+#include "tools/shm_ring.hpp"
+#include "tools/pipeline.hpp"
+#include "tools/thread_config.hpp"
+#include "tools/startup.hpp"
+#include "tools/harvester.hpp"
+#include <fmt/format.h>
 #include <chrono>
+#include <mutex>
+#include <tuple>
 #include <opencv2/opencv.hpp>
-#include <nlohmann/json.hpp>
-#include <deque>
 
-int main()
+//在渲染线程上绘制检测与解算结果
+static void draw_result(
+    cv::Mat & img, const std::vector<auto_buff::FanBlade> & fanblades,
+    const auto_buff::PowerRunePose & rune)
 {
-    //相机初始化(对应曝光, 增益, 设备ID)
-    io::Camera camera(2.5, 16.9, "2bdf:0001");
-    std::chrono::steady_clock::time_point timestamp;  
-    
-    //导入检测点模型和求解中心模型
-    auto_buff::Buff_Detector detector;
-    auto_buff::Buff_Solver solver;
-    
-    //初始化plotjuggler
-    tools::Plotter plotter;
-    
-    //用于平滑旋转中心的历史数据
-    std::deque<cv::Point3f> fanblade_center_history;
-    const size_t max_history = 10;
-    
-    while(true){
-        cv::Mat img;
-        camera.read(img, timestamp);
-        
-        if (img.empty()) {
-            std::cerr << "无法读取相机图像!" << std::endl;
-            continue;
+    // 处理检测到的扇叶
+    for (const auto& fanblade : fanblades) {
+        cv::Scalar color;
+        std::string type_name;
+
+        //根据类型设置颜色
+        switch (fanblade.type) {
+            case auto_buff::_target:
+                color = cv::Scalar(0, 255, 0);  //绿色
+                type_name = "_target";
+                break;
+            case auto_buff::_light:
+                color = cv::Scalar(0, 255, 255); //黄色
+                type_name = "_light";
+                break;
+            case auto_buff::_unlight:
+                color = cv::Scalar(0, 0, 255);  //红色
+                type_name = "_unlight";
+                break;
         }
-        
-        //开始检测扇叶
-        auto fanblades = detector.detect(img);
-        
 
+        //绘制关键点
+        for (size_t i = 0; i < fanblade.points.size(); ++i) {
+            cv::circle(img, fanblade.points[i], 3, color, -1);
+            cv::putText(img, std::to_string(i), 
+                       cv::Point(fanblade.points[i].x + 5, fanblade.points[i].y - 5),
+                       cv::FONT_HERSHEY_SIMPLEX, 0.4, color, 1);
+        }
+
+        //绘制平面中心点
+        cv::circle(img, fanblade.center, 5, color, 2);
+        cv::putText(img, "CENTER", 
+                   cv::Point(fanblade.center.x + 10, fanblade.center.y - 10),
+                   cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 2);
+    }
+
+    if (rune.valid) {
+        //在图像上显示参考扇叶中心的3D位置
+        std::string pos_text = cv::format("3D:(%.0f,%.0f,%.0f)mm", 
+            rune.target_center.x, rune.target_center.y, rune.target_center.z);
+        cv::putText(img, pos_text,
+                   cv::Point(20, 160),
+                   cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 2);
 
-        //创建显示图像
-        cv::Mat display_img = img.clone();
-        cv::Point3f fanblade_center_3d(0, 0, 0);
-        cv::Point3f rotation_center_3d(0, 0, 0);
+        //在图像上显示旋转中心
+        std::string rot_text = cv::format("R-Center:(%.0f,%.0f,%.0f)mm", 
+            rune.center.x, rune.center.y, rune.center.z);
+        cv::putText(img, rot_text,
+                   cv::Point(20, 80),
+                   cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 0, 255), 2);
+    }
+
+    //显示检测数量到的数量
+    std::string count_text = cv::format("Detected: %d", (int)fanblades.size());
+    cv::putText(img, count_text,
+               cv::Point(20, 120),
+               cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
+}
+
+//流水线中传递的数据, 帧带有帧号、丢帧数、相机序号等元数据
+using Frame = io::CameraFrame;
+using Frames = std::vector<Frame>;  //同一时刻各相机的帧, 单相机时只有一帧
+
+struct Detection
+{
+    Frame frame;
+    std::vector<auto_buff::FanBlade> fanblades;
+};
+
+struct Target
+{
+    Detection detection;
+    auto_buff::PowerRunePose rune;
+    auto_buff::AimCommand command;
+};
+
+//plotjuggler输出, 字段只注册一次, 之后按ID写入
+struct Telemetry
+{
+    tools::Plotter & plotter;
+    const uint16_t fanblade_center_x = plotter.field("fanblade_center_x");
+    const uint16_t fanblade_center_y = plotter.field("fanblade_center_y");
+    const uint16_t fanblade_center_z = plotter.field("fanblade_center_z");
+    const uint16_t rotation_center_x = plotter.field("rotation_center_x");
+    const uint16_t rotation_center_y = plotter.field("rotation_center_y");
+    const uint16_t rotation_center_z = plotter.field("rotation_center_z");
+    const uint16_t aim_control = plotter.field("aim_control");
+    const uint16_t aim_yaw = plotter.field("aim_yaw");
+    const uint16_t aim_pitch = plotter.field("aim_pitch");
+    const uint16_t aim_fly_time = plotter.field("aim_fly_time");
+    const uint16_t rune_phase = plotter.field("rune_phase");
+    const uint16_t rune_blade_count = plotter.field("rune_blade_count");
+    const uint16_t reprojection_rms = plotter.field("reprojection_rms");
+    const uint16_t rotation_center_std_x = plotter.field("rotation_center_std_x");
+    const uint16_t rotation_center_std_y = plotter.field("rotation_center_std_y");
+    const uint16_t rotation_center_std_z = plotter.field("rotation_center_std_z");
+    const uint16_t detection_count = plotter.field("detection_count");
+    const uint16_t camera_dropped = plotter.field("camera_dropped");
+    const uint16_t camera_exposure = plotter.field("camera_exposure");
+    const uint16_t camera_gain = plotter.field("camera_gain");
+    const uint16_t camera_index = plotter.field("camera");
+
+    void record(const Target & target)
+    {
+        const auto & rune = target.rune;
+        const auto & command = target.command;
         
-        // 处理检测到的扇叶
-        for (const auto& fanblade : fanblades) {
-            cv::Scalar color;
-            std::string type_name;
-            
-            //根据类型设置颜色
-            switch (fanblade.type) {
-                case auto_buff::_target:
-                    color = cv::Scalar(0, 255, 0);  //绿色
-                    type_name = "_target";
-                    break;
-                case auto_buff::_light:
-                    color = cv::Scalar(0, 255, 255); //黄色
-                    type_name = "_light";
-                    break;
-                case auto_buff::_unlight:
-                    color = cv::Scalar(0, 0, 255);  //红色
-                    type_name = "_unlight";
-                    break;
-            }
-            
-            //绘制关键点
-            for (size_t i = 0; i < fanblade.points.size(); ++i) {
-                cv::circle(display_img, fanblade.points[i], 3, color, -1);
-                cv::putText(display_img, std::to_string(i), 
-                           cv::Point(fanblade.points[i].x + 5, fanblade.points[i].y - 5),
-                           cv::FONT_HERSHEY_SIMPLEX, 0.4, color, 1);
-            }
-            
-            //绘制平面中心点
-            cv::circle(display_img, fanblade.center, 5, color, 2);
-            cv::putText(display_img, "CENTER", 
-                       cv::Point(fanblade.center.x + 10, fanblade.center.y - 10),
-                       cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 2);
-            
-            //解算扇叶中心的3D位置
-            fanblade_center_3d = solver.solveFanbladeCenter(fanblade);
-            
-            //在图像上显示3D位置
-            std::string pos_text = cv::format("3D:(%.0f,%.0f,%.0f)mm", 
-                fanblade_center_3d.x, fanblade_center_3d.y, fanblade_center_3d.z);
-            cv::putText(display_img, pos_text,
-                       cv::Point(fanblade.center.x - 80, fanblade.center.y + 25),
-                       cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255), 1);
-            
-            //保存历史数据用于平滑
-            fanblade_center_history.push_back(fanblade_center_3d);
-            if (fanblade_center_history.size() > max_history) {
-                fanblade_center_history.pop_front();
-            }
-        }
+        //扇叶中心与能量中心位置曲线, 解算失败时为0
+        auto fanblade_center_3d = rune.valid ? rune.target_center : cv::Point3f(0, 0, 0);
+        auto rotation_center_3d = rune.valid ? rune.center : cv::Point3f(0, 0, 0);
+        plotter.record(fanblade_center_x, fanblade_center_3d.x);
+        plotter.record(fanblade_center_y, fanblade_center_3d.y);
+        plotter.record(fanblade_center_z, fanblade_center_3d.z);
+        plotter.record(rotation_center_x, rotation_center_3d.x);
+        plotter.record(rotation_center_y, rotation_center_3d.y);
+        plotter.record(rotation_center_z, rotation_center_3d.z);
         
-        //由扇叶中心推算能量中心
-        if (!fanblade_center_history.empty()) {
-            std::vector<cv::Point3f> centers(fanblade_center_history.begin(), 
-                                            fanblade_center_history.end());
-            rotation_center_3d = solver.solveRotationCenter(centers);
-            
-            //在图像上显示旋转中心
-            std::string rot_text = cv::format("R-Center:(%.0f,%.0f,%.0f)mm", 
-                rotation_center_3d.x, rotation_center_3d.y, rotation_center_3d.z);
-            cv::putText(display_img, rot_text,
-                       cv::Point(20, 80),
-                       cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 0, 255), 2);
-        }
+        //云台指令曲线
+        plotter.record(aim_control, command.control);
+        plotter.record(aim_yaw, command.yaw * 57.3);
+        plotter.record(aim_pitch, command.pitch * 57.3);
+        plotter.record(aim_fly_time, command.fly_time);
         
-        //显示检测数量到的数量
-        std::string count_text = cv::format("Detected: %d", (int)fanblades.size());
-        cv::putText(display_img, count_text,
-                   cv::Point(20, 120),
-                   cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0), 2);
+        //能量机关相位与参与解算的扇叶数
+        plotter.record(rune_phase, rune.phase * 57.3);
+        plotter.record(rune_blade_count, rune.blade_count);
         
-        //plotjuggler输出
-        nlohmann::json data;
+        //解算质量: 重投影误差与旋转中心的标准差
+        plotter.record(reprojection_rms, rune.reprojection_rms);
+        plotter.record(rotation_center_std_x, std::sqrt(rune.covariance(3, 3)));
+        plotter.record(rotation_center_std_y, std::sqrt(rune.covariance(4, 4)));
+        plotter.record(rotation_center_std_z, std::sqrt(rune.covariance(5, 5)));
         
-        //扇叶中心位置曲线
-        data["fanblade_center_x"] = fanblade_center_3d.x;
-        data["fanblade_center_y"] = fanblade_center_3d.y;
-        data["fanblade_center_z"] = fanblade_center_3d.z;
+        //额外信息
+        plotter.record(detection_count, target.detection.fanblades.size());
+        plotter.record(camera_dropped, target.detection.frame.dropped);
         
-        //能量中心位置曲线
-        data["rotation_center_x"] = rotation_center_3d.x;
-        data["rotation_center_y"] = rotation_center_3d.y;
-        data["rotation_center_z"] = rotation_center_3d.z;
+        //每帧实际生效的曝光(us)与增益(dB), 由相机随帧返回
+        plotter.record(camera_exposure, target.detection.frame.exposure_us);
+        plotter.record(camera_gain, target.detection.frame.gain);
+        plotter.record(camera_index, target.detection.frame.camera);  //多相机时结果来自哪台相机
         
-        //额外信息
-        data["detection_count"] = fanblades.size();
+        plotter.commit();
+    }
+};
+
+//发布到共享内存的结果文本
+static std::string result_text(const Target & target)
+{
+    const auto & rune = target.rune;
+    auto result = fmt::format("Detected: {}\n", target.detection.fanblades.size());
+    if (rune.valid)
+        result += fmt::format(
+            "3D:({:.0f},{:.0f},{:.0f})mm\nR-Center:({:.0f},{:.0f},{:.0f})mm\nrms: {:.2f}px\n",
+            rune.target_center.x, rune.target_center.y, rune.target_center.z,
+            rune.center.x, rune.center.y, rune.center.z, rune.reprojection_rms);
+    return result;
+}
+
+//按 scale 缩放后平移, 用于在图像坐标与全分辨率传感器坐标之间转换扇叶
+static void map_fanblades(std::vector<auto_buff::FanBlade> & fanblades, float scale, cv::Point2f offset)
+{
+    for (auto & fanblade : fanblades) {
+        fanblade.center = fanblade.center * scale + offset;
+        for (auto & point : fanblade.points) point = point * scale + offset;
+        fanblade.width *= scale;
+        fanblade.height *= scale;
+    }
+}
+
+//传感器端ROI: 覆盖观测到的扇叶中心轨迹(即能量机关的转动范围)并留出扇叶大小的余量
+//只有目标超出当前窗口时才重新设置, 设置时相机需短暂停流; 长时间丢失后恢复全画幅
+class SensorWindow
+{
+public:
+    //fanblades 为全分辨率坐标, 需要修改窗口时返回新窗口(空矩形表示全画幅)
+    std::optional<cv::Rect> update(const std::vector<auto_buff::FanBlade> & fanblades)
+    {
+        if (fanblades.empty()) {
+            if (++lost_ < 50 || window_.empty()) return std::nullopt;
+            tracked_ = false;
+            window_ = cv::Rect();
+            return window_;
+        }
+        lost_ = 0;
         
-        plotter.plot(data);
+        const auto & fanblade = fanblades.front();
+        auto blade = cv::boundingRect(fanblade.points);
+        if (!tracked_) track_ = cv::Rect(fanblade.center, cv::Size(1, 1)), tracked_ = true;
+        track_ |= cv::Rect(fanblade.center, cv::Size(1, 1));
         
+        auto margin = std::max(blade.width, blade.height);
+        auto needed = track_ + cv::Size(2 * margin, 2 * margin) - cv::Point(margin, margin);
+        if (!window_.empty() && (needed & window_) == needed) return std::nullopt;
         
-        //按键控制
-        int key = cv::waitKey(1);
-        if (key == 'q') {  //q健退出
-            break;
-        } else if (key == 's' || key == 'S') {  //s键保存图像
-            std::string filename = "capture_" + 
-                std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + 
-                ".jpg";
-            cv::imwrite(filename, display_img);
-            std::cout << "图像已保存: " << filename << std::endl;
+        //多留出一个扇叶的余量, 减少重新设置的次数
+        window_ = needed + cv::Size(2 * margin, 2 * margin) - cv::Point(margin, margin);
+        return window_;
+    }
+
+private:
+    bool tracked_ = false;
+    cv::Rect track_;
+    cv::Rect window_;
+    int lost_ = 0;
+};
+
+//检测结果与解算不一致(重投影误差大)的帧, 标注换算回图像坐标后交给收集器
+static void harvest_inconsistent(tools::Harvester & harvester, const Detection & detection)
+{
+    const auto & frame = detection.frame;
+    auto fanblades = detection.fanblades;
+    map_fanblades(fanblades, 1.0f / frame.binning, -cv::Point2f(frame.offset) / frame.binning);
+    
+    std::vector<tools::HarvestLabel> labels;
+    for (const auto & fanblade : fanblades)
+        labels.push_back({0, cv::Rect2f(cv::boundingRect(fanblade.points)), fanblade.points});
+    harvester.submit(frame.img, labels, "inconsistent");
+}
+
+//检测到的扇叶外接矩形向外扩展一半, 作为自动曝光的测光区域; 未检测到时用整幅图像
+static cv::Rect metering_roi(const std::vector<auto_buff::FanBlade> & fanblades)
+{
+    std::vector<cv::Point2f> points;
+    for (const auto & fanblade : fanblades)
+        points.insert(points.end(), fanblade.points.begin(), fanblade.points.end());
+    if (points.empty()) return cv::Rect();
+    
+    auto rect = cv::boundingRect(points);
+    return rect + cv::Size(rect.width, rect.height) - cv::Point(rect.width / 2, rect.height / 2);
+}
+
+//多相机配置(--cameras)中的一台相机: 采集参数、内参与到基准相机的外参, 格式见 configs/cameras.yaml
+struct CameraSetup
+{
+    io::CameraConfig config;
+    cv::Mat camera_matrix, dist_coeffs;  //基准相机可省略, 此时使用 Buff_Solver 中的默认标定
+    cv::Matx33d R_camera2ref = cv::Matx33d::eye();
+    cv::Vec3d t_camera2ref;
+};
+
+//读取失败时返回空列表
+static std::vector<CameraSetup> load_camera_rig(const std::string & path, const io::CameraConfig & base)
+{
+    cv::FileStorage fs;
+    try {
+        fs.open(path, cv::FileStorage::READ);
+    } catch (const cv::Exception & e) {
+        tools::logger()->error("Failed to parse camera rig {}: {}", path, e.what());
+        return {};
+    }
+    if (!fs.isOpened()) {
+        tools::logger()->error("Camera rig {} not found.", path);
+        return {};
+    }
+    
+    //trigger 非0时第一台相机作为主相机输出曝光信号, 其余相机由它硬件触发
+    bool trigger = !fs["trigger"].empty() && static_cast<int>(fs["trigger"]) != 0;
+    std::vector<CameraSetup> rig;
+    for (const auto & node : fs["cameras"]) {
+        CameraSetup setup;
+        setup.config = base;
+        setup.config.serial = static_cast<std::string>(node["serial"]);
+        if (trigger) setup.config.trigger = rig.empty() ? io::Trigger::master : io::Trigger::slave;
+        node["camera_matrix"] >> setup.camera_matrix;
+        node["dist_coeffs"] >> setup.dist_coeffs;
+        cv::Mat R, t;
+        node["R_camera2ref"] >> R;
+        node["t_camera2ref"] >> t;
+        if (!R.empty()) setup.R_camera2ref = R;
+        if (!t.empty()) setup.t_camera2ref = t;
+        //非基准相机的结果要经外参换算, 必须使用它自己的标定
+        if (!rig.empty() && (setup.camera_matrix.empty() || R.empty() || t.empty())) {
+            tools::logger()->error("Camera {} in {} needs camera_matrix, R_camera2ref and t_camera2ref.",
+                                   setup.config.serial, path);
+            return {};
         }
+        if (setup.dist_coeffs.empty()) setup.dist_coeffs = cv::Mat::zeros(5, 1, CV_64F);
+        rig.push_back(setup);
     }
+    return rig;
+}
+
+//主程序使用的相机: 单相机时直接读取, 多相机时由 CameraGroup 按时间戳把各相机的帧配成一组
+struct Cameras
+{
+    std::unique_ptr<io::Camera> single;
+    std::unique_ptr<io::CameraGroup> group;
+    
+    size_t size() const { return group ? group->size() : 1; }
+    io::Camera & operator[](size_t index) { return group ? group->camera(index) : *single; }
+    
+    io::ReadStatus read_for(Frames & frames, std::chrono::milliseconds timeout)
+    {
+        if (group) return group->read_for(frames, timeout);
+        frames.resize(1);
+        return single->read_for(frames[0], timeout);
+    }
+};
+
+//多相机时取可以瞄准、参与解算的扇叶最多的结果, 相同时取重投影误差小的
+static bool better_rune(const auto_buff::PowerRunePose & a, const auto_buff::PowerRunePose & b)
+{
+    auto rank = [](const auto_buff::PowerRunePose & rune) {
+        return std::make_tuple(rune.valid && rune.has_target, rune.valid, rune.blade_count, -rune.reprojection_rms);
+    };
+    return rank(a) > rank(b);
+}
+
+//用法: ./main [--headless] [--publish] [--mindvision] [--bayer sdk|opencv|bilinear] [--auto-exposure] [--sensor-roi] [--threads 线程配置] [--record 录制目录] [--harvest 样本目录] [--cameras 多相机配置] [--replay 录像目录或视频 [realtime|fast|lockstep]]
+int main(int argc, char ** argv)
+{
+    //启动时间线的起点
+    tools::Startup startup;
+    
+    //异步日志, 避免相机线程被磁盘/终端输出阻塞
+    tools::set_async_logger();
+    
+    bool headless = false, publish = false, auto_exposure = false, sensor_roi = false;
+    auto backend = io::CameraBackend::hikrobot;
+    auto bayer = io::BayerBackend::automatic;  //默认在第一帧上测试后选用最快的实现
+    std::string record_dir, replay_path, harvest_dir, rig_path, thread_config = "configs/threads.yaml";
+    auto replay_mode = io::ReplayMode::realtime;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") headless = true;
+        else if (arg == "--publish") publish = true;
+        else if (arg == "--auto-exposure") auto_exposure = true;
+        else if (arg == "--mindvision") backend = io::CameraBackend::mindvision;
+        else if (arg == "--bayer" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "sdk") bayer = io::BayerBackend::sdk;
+            else if (name == "opencv") bayer = io::BayerBackend::opencv;
+            else if (name == "bilinear") bayer = io::BayerBackend::bilinear;
+        }
+        else if (arg == "--sensor-roi") sensor_roi = true;
+        else if (arg == "--threads" && i + 1 < argc) thread_config = argv[++i];
+        else if (arg == "--record" && i + 1 < argc) record_dir = argv[++i];
+        else if (arg == "--harvest" && i + 1 < argc) harvest_dir = argv[++i];
+        else if (arg == "--cameras" && i + 1 < argc) rig_path = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+            //回放节奏只能紧跟在 --replay 的路径之后
+            std::string mode = i + 1 < argc ? argv[i + 1] : "";
+            if (mode == "realtime" || mode == "fast" || mode == "lockstep") {
+                replay_mode = mode == "fast"       ? io::ReplayMode::fast
+                            : mode == "lockstep"   ? io::ReplayMode::lockstep
+                                                   : io::ReplayMode::realtime;
+                i++;
+            }
+        }
+    }
+    
+    //绑核与实时优先级配置, 需先于相机、模型和流水线的线程创建
+    tools::load_thread_config(thread_config);
+    
+    //相机配置: 默认一台相机(默认曝光2.5ms, 增益16.9dB); --cameras 给出多台相机, 第一台为基准相机
+    io::CameraConfig base_config;
+    base_config.backend = backend;
+    base_config.bayer = bayer;
+    base_config.exposure_control.enabled = auto_exposure;
+    //传感器ROI缩小后相机可以出更高的帧率, 不再限制在默认的150fps, 帧率由曝光时间与窗口大小决定
+    if (sensor_roi) base_config.frame_rate = 0;
+    std::vector<CameraSetup> rig{{base_config}};
+    if (!rig_path.empty() && !replay_path.empty()) {
+        tools::logger()->warn("--cameras is ignored when replaying.");
+    } else if (!rig_path.empty()) {
+        rig = load_camera_rig(rig_path, base_config);
+        if (rig.empty()) return -1;
+    }
+    
+    //录制、相机、模型编译、标定与弹道表互不依赖, 并行初始化
+    //给出目录时录制原始Bayer帧(预分配缓冲区)
+    auto recorder_task = startup.launch("recorder", [&] {
+        std::unique_ptr<io::Recorder> recorder;
+        if (!record_dir.empty()) recorder = std::make_unique<io::Recorder>(record_dir);
+        return recorder;
+    });
+    
+    //相机初始化(对应曝光, 增益, 设备ID), 或回放录像; 多台相机时各自一个采集线程, 帧按时间戳配对
+    auto camera_task = startup.launch("camera", [&] {
+        auto cameras = std::make_unique<Cameras>();
+        if (!replay_path.empty()) {
+            cameras->single = std::make_unique<io::Camera>(replay_path, replay_mode);
+        } else if (rig.size() > 1) {
+            std::vector<io::CameraConfig> configs;
+            for (const auto & setup : rig) configs.push_back(setup.config);
+            cameras->group = std::make_unique<io::CameraGroup>(configs);
+        } else {
+            cameras->single = std::make_unique<io::Camera>(rig[0].config);
+        }
+        return cameras;
+    });
+    
+    //导入检测点模型(编译或从缓存导入)并预热, 使第一帧的推理耗时与稳态一致
+    //每台相机一个检测器(各自的推理请求), 第二个起直接从编译缓存导入
+    auto detector_task = startup.launch("detector", [&] {
+        std::vector<std::unique_ptr<auto_buff::Buff_Detector>> detectors;
+        for (size_t i = 0; i < rig.size(); i++) {
+            auto detector = std::make_unique<auto_buff::Buff_Detector>(true);  //开启关键点亚像素精修
+            detector->warmup();
+            detectors.push_back(std::move(detector));
+        }
+        return detectors;
+    });
+    
+    //求解中心模型(相机标定参数), 多相机时每台相机一个, 结果统一换算到基准相机系
+    auto solver_task = startup.launch("solver", [&] {
+        std::vector<std::unique_ptr<auto_buff::Buff_Solver>> solvers;
+        for (const auto & setup : rig) {
+            if (setup.camera_matrix.empty())
+                solvers.push_back(std::make_unique<auto_buff::Buff_Solver>());
+            else
+                solvers.push_back(std::make_unique<auto_buff::Buff_Solver>(
+                    setup.camera_matrix, setup.dist_coeffs, setup.R_camera2ref, setup.t_camera2ref));
+        }
+        return solvers;
+    });
+    
+    //弹道解算(首次运行建表, 之后从cache/读取)
+    auto aimer_task = startup.launch("aimer", [] { return std::make_unique<auto_buff::Aimer>(); });
+    
+    //可视化在独立的低优先级线程上进行, 最高30Hz, 来不及时丢帧
+    std::unique_ptr<tools::Visualizer> visualizer;
+    if (!headless) visualizer = std::make_unique<tools::Visualizer>("Detection Results", 30);
+    
+    //发布到共享内存, 供 shm_viewer 等外部进程只读查看, 无需X显示
+    std::unique_ptr<tools::ShmPublisher> publisher;
+    if (publish) publisher = std::make_unique<tools::ShmPublisher>();
+    
+    tools::Plotter plotter;
+    Telemetry telemetry{plotter};
+    
+    //等待并行初始化完成; 录制器先于相机声明, 保证相机先析构
+    auto recorder = recorder_task.get();
+    auto cameras = camera_task.get();
+    if (recorder) (*cameras)[0].set_raw_hook(recorder->hook());  //多相机时只录制基准相机
+    auto detectors = detector_task.get();
+    
+    //困难样本收集: 低置信度检测与重投影误差大的解算结果, 在后台线程限频写盘
+    std::shared_ptr<tools::Harvester> harvester;
+    if (!harvest_dir.empty()) {
+        harvester = std::make_shared<tools::Harvester>(harvest_dir);
+        for (auto & detector : detectors) detector->set_harvester(harvester);
+    }
+    auto solvers = solver_task.get();
+    auto aimer = aimer_task.get();
+    startup.mark("initialized");
+    
+    //相机 -> 检测 -> 解算/弹道 -> 输出, 各阶段各占一个线程
+    //实时数据源只保留最新一帧; 快速/逐帧回放则不丢帧
+    auto live = replay_path.empty() || replay_mode == io::ReplayMode::realtime;
+    auto policy = live ? tools::Backpressure::drop_oldest : tools::Backpressure::block;
+    tools::Pipeline pipeline;
+    pipeline.on_thread_start(tools::apply_thread_policy);
+    
+    auto frames = pipeline.source("camera", [&]() -> std::optional<Frames> {
+        static auto & jitter = tools::jitter_meter("camera");
+        jitter.tick();
+        Frames frames;
+        //有时限读取, 相机掉线恢复期间也能响应退出
+        while (!pipeline.stopping()) {
+            auto status = cameras->read_for(frames, std::chrono::milliseconds(100));
+            if (status == io::ReadStatus::end) return std::nullopt;  //回放结束
+            if (status == io::ReadStatus::ok) {
+                static std::once_flag first_frame;
+                std::call_once(first_frame, [&] { startup.mark("first frame"); });
+                return frames;
+            }
+            TOOLS_WARN_EVERY(std::chrono::seconds(1), "No frame from camera ({})",
+                status == io::ReadStatus::timeout ? "timeout" : "reconnecting");
+        }
+        return std::nullopt;
+    }, 1, policy);
+    
+    //开启 --sensor-roi 时相机只传输能量机关附近的区域, 检测结果换算回全分辨率坐标再解算
+    std::vector<SensorWindow> sensor_windows(cameras->size());
+    auto detections = pipeline.stage("detect", frames, [&](Frames && frames) {
+        //各相机的检测器先全部开始推理再依次等待, 多相机时推理并行进行, 延迟不随相机数成倍增加
+        for (const auto & frame : frames) detectors[frame.camera]->start(frame.img);
+        std::vector<Detection> detections;
+        for (auto & frame : frames) {
+            auto fanblades = detectors[frame.camera]->wait();
+            map_fanblades(fanblades, frame.binning, frame.offset);
+            auto & camera = (*cameras)[frame.camera];
+            if (auto_exposure) camera.set_metering_roi(metering_roi(fanblades));
+            if (sensor_roi)
+                if (auto window = sensor_windows[frame.camera].update(fanblades)) camera.set_sensor_roi(*window);
+            detections.push_back(Detection{std::move(frame), std::move(fanblades)});
+        }
+        return detections;
+    });
+    
+    //每台相机的扇叶各自联合解算能量机关位姿(换算到基准相机系), 取最好的结果瞄准参考扇叶中心
+    auto targets = pipeline.stage("solve", detections, [&](std::vector<Detection> && detections) {
+        std::optional<Target> best;
+        for (auto & detection : detections) {
+            Target target{std::move(detection)};
+            target.rune = solvers[target.detection.frame.camera]->solvePowerRune(target.detection.fanblades);
+            if (harvester && target.rune.valid && target.rune.reprojection_rms > 2.0)
+                harvest_inconsistent(*harvester, target.detection);
+            if (!best || better_rune(target.rune, best->rune)) best = std::move(target);
+        }
+        //没有识别出待击打扇叶时参考扇叶可能是已激活或未点亮的, 只解算不瞄准
+        if (best->rune.valid && best->rune.has_target) best->command = aimer->aim(best->rune.target_center);
+        return std::move(*best);
+    }, 2, policy);
+    
+    //输出阶段: 曲线、共享内存与可视化都不会阻塞上游
+    pipeline.sink("output", targets, [&](Target && target) {
+        static auto & jitter = tools::jitter_meter("output");
+        jitter.tick();
+        //里程碑只需记录一次, 之后每帧只检查一次标志
+        static std::once_flag first_result, first_aim;
+        std::call_once(first_result, [&] { startup.mark("first result"); });
+        if (target.rune.valid && target.rune.has_target) std::call_once(first_aim, [&] { startup.mark("first aim"); });  //开始瞄准的时刻
+        telemetry.record(target);
+        
+        const auto & frame = target.detection.frame;
+        if (publisher && publisher->ready(frame.timestamp))
+            publisher->publish(frame.img, frame.timestamp, result_text(target));
+        
+        if (visualizer) {
+            auto fanblades = target.detection.fanblades;
+            map_fanblades(fanblades, 1.0f / frame.binning, -cv::Point2f(frame.offset) / frame.binning);
+            auto rune = target.rune;
+            visualizer->submit(frame.img, [fanblades, rune](cv::Mat & canvas) {
+                draw_result(canvas, fanblades, rune);
+            });
+            if (visualizer->key() == 'q') pipeline.stop();  //q健退出, s键保存图像由渲染线程处理
+        }
+    });
     
-    cv::destroyAllWindows();
+    pipeline.run();
+    pipeline.report();
+    startup.report();
+    cameras.reset();  //先停止采集线程再输出抖动统计
+    tools::report_jitter();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,163 @@
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tasks/yolo11_buff.hpp"
+#include "tools/logger.hpp"
+#include "tools/thread_config.hpp"
+
+// 用法: ./model_benchmark 视频 [--models a.xml,b.xml] [--sizes 640,480] [--precisions default,f16]
+//                         [--streams 1,2] [--threads 0,4] [--frames 300] [--warmup 20] [--threads-config 配置]
+// 对模型、输入尺寸、精度提示、流数、线程数的所有组合逐一测试, 第一个组合作为一致性比较的基准
+namespace
+{
+std::vector<std::string> split(const std::string & text)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(text);
+  std::string item;
+  while (std::getline(ss, item, ',')) items.push_back(item == "default" ? "" : item);
+  return items;
+}
+
+std::vector<int> split_int(const std::string & text)
+{
+  std::vector<int> values;
+  for (const auto & item : split(text)) values.push_back(std::stoi(item));
+  return values;
+}
+
+using Result = std::optional<auto_buff::YOLO11_BUFF::Object>;
+
+// 与基准的检测一致性: 有无目标是否一致, 都检测到时的框IoU与关键点平均偏差
+struct Agreement
+{
+  int frames = 0, same_presence = 0, both = 0;
+  double iou_sum = 0, keypoint_error_sum = 0;
+
+  void add(const Result & reference, const Result & result)
+  {
+    frames++;
+    if (reference.has_value() == result.has_value()) same_presence++;
+    if (!reference || !result) return;
+
+    both++;
+    auto inter = (reference->rect & result->rect).area();
+    auto uni = reference->rect.area() + result->rect.area() - inter;
+    iou_sum += uni > 0 ? inter / uni : 0;
+
+    double error = 0;
+    for (size_t i = 0; i < reference->kpt.size(); i++)
+      error += cv::norm(reference->kpt[i] - result->kpt[i]);
+    keypoint_error_sum += error / std::max<size_t>(1, reference->kpt.size());
+  }
+};
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  if (argc < 2) {
+    fmt::print(stderr, "usage: {} video [--models ...] [--sizes ...] [--precisions ...]\n", argv[0]);
+    return -1;
+  }
+
+  std::string video_path = argv[1], thread_config = "configs/threads.yaml";
+  std::vector<std::string> models = {auto_buff::BuffModelConfig().model_path};
+  std::vector<int> sizes = {640}, streams = {0}, threads = {0};
+  std::vector<std::string> precisions = {""};
+  int max_frames = 300, warmup = 20;
+  for (int i = 2; i + 1 < argc; i += 2) {
+    std::string arg = argv[i], value = argv[i + 1];
+    if (arg == "--models") models = split(value);
+    else if (arg == "--sizes") sizes = split_int(value);
+    else if (arg == "--precisions") precisions = split(value);
+    else if (arg == "--streams") streams = split_int(value);
+    else if (arg == "--threads") threads = split_int(value);
+    else if (arg == "--frames") max_frames = std::stoi(value);
+    else if (arg == "--warmup") warmup = std::stoi(value);
+    else if (arg == "--threads-config") thread_config = value;
+  }
+
+  tools::load_thread_config(thread_config);
+  tools::apply_thread_policy("detect");  // 与主程序的检测阶段相同的核心
+
+  // 预先解码到内存, 计时中不包含解码
+  std::vector<cv::Mat> frames;
+  cv::VideoCapture cap(video_path);
+  cv::Mat img;
+  while ((int)frames.size() < max_frames && cap.read(img)) frames.push_back(img.clone());
+  if (frames.empty()) {
+    tools::logger()->error("No frames read from {}", video_path);
+    return -1;
+  }
+  tools::logger()->info("Loaded {} frames from {}", frames.size(), video_path);
+
+  std::vector<Result> reference;
+  fmt::print(
+    "{:<36} {:>5} {:>5} {:>3} {:>3} {:>8} {:>8} {:>8} {:>8} {:>7} {:>7} {:>6} {:>7}\n", "model",
+    "size", "prec", "str", "thr", "p50/ms", "p90/ms", "p99/ms", "max/ms", "fps", "agree", "IoU",
+    "kpt/px");
+
+  for (const auto & model : models)
+    for (auto size : sizes)
+      for (const auto & precision : precisions)
+        for (auto stream : streams)
+          for (auto thread : threads) {
+            auto_buff::BuffModelConfig config;
+            config.model_path = model;
+            config.input_size = size;
+            config.precision = precision;
+            config.streams = stream;
+            config.threads = thread;
+
+            std::optional<auto_buff::YOLO11_BUFF> yolo;
+            try {
+              yolo.emplace(false, config);
+            } catch (const std::exception & e) {
+              tools::logger()->warn("Skip {} {} {}: {}", model, size, precision, e.what());
+              continue;
+            }
+
+            for (int i = 0; i < warmup; i++) yolo->get_onecandidatebox(frames[i % frames.size()]);
+
+            std::vector<double> costs_ms;
+            std::vector<Result> results;
+            auto begin = std::chrono::steady_clock::now();
+            for (const auto & frame : frames) {
+              auto start = std::chrono::steady_clock::now();
+              auto objects = yolo->get_onecandidatebox(frame);
+              auto end = std::chrono::steady_clock::now();
+              costs_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+              results.push_back(objects.empty() ? Result() : Result(objects.front()));
+            }
+            auto total_s =
+              std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+            if (reference.empty()) reference = results;
+            Agreement agreement;
+            for (size_t i = 0; i < results.size(); i++) agreement.add(reference[i], results[i]);
+
+            std::sort(costs_ms.begin(), costs_ms.end());
+            auto percentile = [&](double p) {
+              return costs_ms[static_cast<size_t>(p * (costs_ms.size() - 1))];
+            };
+            auto both = std::max(1, agreement.both);
+            fmt::print(
+              "{:<36} {:>5} {:>5} {:>3} {:>3} {:>8.2f} {:>8.2f} {:>8.2f} {:>8.2f} {:>7.1f} "
+              "{:>6.1f}% {:>6.3f} {:>7.2f}\n",
+              model.substr(model.size() > 36 ? model.size() - 36 : 0), size,
+              precision.empty() ? "def" : precision, stream, thread, percentile(0.5),
+              percentile(0.9), percentile(0.99), costs_ms.back(), frames.size() / total_s,
+              100.0 * agreement.same_presence / agreement.frames, agreement.iou_sum / both,
+              agreement.keypoint_error_sum / both);
+          }
+
+  return 0;
+}
@@ -0,0 +1,110 @@
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "io/camera_group.hpp"
+#include "tools/logger.hpp"
+#include "tools/thread_config.hpp"
+
+// 用法: ./multi_camera 序列号1,序列号2 [--trigger] [--exposure 2.5] [--gain 16.9] [--tolerance-us 3000]
+//                      [--headless] [--threads 配置]
+// 第一台相机为基准(近距离), 其余相机(如打符用的长焦相机)与之按时间戳配对
+// --trigger: 第一台相机作为主相机输出曝光信号, 其余相机由外部触发
+int main(int argc, char ** argv)
+{
+  if (argc < 2) {
+    fmt::print(stderr, "usage: {} serial1,serial2 [--trigger] [--headless] ...\n", argv[0]);
+    return -1;
+  }
+
+  std::vector<std::string> serials;
+  std::stringstream ss(argv[1]);
+  std::string serial;
+  while (std::getline(ss, serial, ',')) serials.push_back(serial);
+
+  bool trigger = false, headless = false;
+  double exposure_ms = 2.5, gain = 16.9;
+  int tolerance_us = 3000;
+  std::string thread_config = "configs/threads.yaml";
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--trigger") trigger = true;
+    else if (arg == "--headless") headless = true;
+    else if (i + 1 < argc && arg == "--exposure") exposure_ms = std::stod(argv[++i]);
+    else if (i + 1 < argc && arg == "--gain") gain = std::stod(argv[++i]);
+    else if (i + 1 < argc && arg == "--tolerance-us") tolerance_us = std::stoi(argv[++i]);
+    else if (i + 1 < argc && arg == "--threads") thread_config = argv[++i];
+  }
+
+  tools::load_thread_config(thread_config);
+
+  std::vector<io::CameraConfig> configs;
+  for (size_t i = 0; i < serials.size(); i++) {
+    io::CameraConfig config;
+    config.exposure_ms = exposure_ms;
+    config.gain = gain;
+    config.serial = serials[i];
+    if (trigger) config.trigger = i == 0 ? io::Trigger::master : io::Trigger::slave;
+    configs.push_back(config);
+  }
+
+  io::CameraGroup cameras(configs, std::chrono::microseconds(tolerance_us));
+
+  std::vector<io::CameraFrame> frames;
+  auto last_report = std::chrono::steady_clock::now();
+  int groups = 0;
+  double max_skew_ms = 0, skew_sum_ms = 0;
+  uint64_t dropped = 0;
+
+  while (true) {
+    auto status = cameras.read_for(frames, std::chrono::milliseconds(100));
+    if (status == io::ReadStatus::reconnecting) {
+      TOOLS_WARN_EVERY(std::chrono::seconds(1), "Camera reconnecting...");
+      continue;
+    }
+    if (status != io::ReadStatus::ok) continue;
+
+    groups++;
+    for (size_t i = 1; i < frames.size(); i++) {
+      auto skew_ms = std::chrono::duration<double, std::milli>(
+                       frames[i].timestamp - frames[0].timestamp)
+                       .count();
+      max_skew_ms = std::max(max_skew_ms, std::abs(skew_ms));
+      skew_sum_ms += std::abs(skew_ms);
+    }
+    for (const auto & frame : frames) dropped += frame.dropped;
+
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration<double>(now - last_report).count();
+    if (elapsed >= 1) {
+      auto pairs = std::max<size_t>(1, groups * (frames.size() - 1));
+      tools::logger()->info(
+        "{:.1f} groups/s, skew mean {:.3f} ms, max {:.3f} ms, dropped {}, unmatched {}",
+        groups / elapsed, skew_sum_ms / pairs, max_skew_ms, dropped, cameras.unmatched());
+      last_report = now;
+      groups = 0, max_skew_ms = 0, skew_sum_ms = 0, dropped = 0;
+    }
+
+    if (headless) continue;
+
+    // 缩放到同一高度后横向拼接
+    std::vector<cv::Mat> resized;
+    for (const auto & frame : frames) {
+      cv::Mat img;
+      cv::resize(frame.img, img, cv::Size(), 480.0 / frame.img.rows, 480.0 / frame.img.rows);
+      resized.push_back(img);
+    }
+    cv::Mat canvas;
+    cv::hconcat(resized, canvas);
+    cv::imshow("multi_camera", canvas);
+    if (cv::waitKey(1) == 'q') break;
+  }
+
+  tools::report_jitter();
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tools/logger.hpp"
+#include "tools/plotter.hpp"
+
+// 对比同步JSON发送与异步批量遥测在调用方线程上的每帧开销
+// 按固定帧率发送, 只统计调用本身的耗时
+// 用法: ./plotter_benchmark [帧数] [帧率]
+int main(int argc, char ** argv)
+{
+  const int frames = argc > 1 ? std::stoi(argv[1]) : 5000;
+  const double rate = argc > 2 ? std::stod(argv[2]) : 1000;
+  const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::duration<double>(1.0 / rate));
+  const int field_num = 17;  // 与main.cpp中的字段数一致
+
+  std::vector<std::string> names;
+  for (int i = 0; i < field_num; i++) names.emplace_back("field_" + std::to_string(i));
+
+  auto per_frame_us = [frames](std::chrono::steady_clock::duration total) {
+    return std::chrono::duration<double, std::micro>(total).count() / frames;
+  };
+
+  // 1. 原有接口: 每帧构造JSON并同步sendto
+  {
+    tools::Plotter plotter;
+    std::chrono::steady_clock::duration total{0};
+    auto next = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+      auto begin = std::chrono::steady_clock::now();
+      nlohmann::json data;
+      for (int i = 0; i < field_num; i++) data[names[i]] = frame * 0.001 + i;
+      plotter.plot(data);
+      total += std::chrono::steady_clock::now() - begin;
+
+      next += period;
+      std::this_thread::sleep_until(next);
+    }
+    tools::logger()->info("plot(json): {:.3f} us/frame", per_frame_us(total));
+  }
+
+  // 2. 注册ID + record/commit, 分别测试兼容JSON与二进制两种输出
+  for (auto mode : {tools::Plotter::Mode::json, tools::Plotter::Mode::binary}) {
+    tools::Plotter plotter("127.0.0.1", 9870, mode);
+    std::vector<uint16_t> ids;
+    for (const auto & name : names) ids.emplace_back(plotter.field(name));
+
+    std::chrono::steady_clock::duration total{0};
+    auto next = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+      auto begin = std::chrono::steady_clock::now();
+      for (int i = 0; i < field_num; i++) plotter.record(ids[i], frame * 0.001 + i);
+      plotter.commit();
+      total += std::chrono::steady_clock::now() - begin;
+
+      next += period;
+      std::this_thread::sleep_until(next);
+    }
+    tools::logger()->info(
+      "record/commit ({}): {:.3f} us/frame, dropped {} samples",
+      mode == tools::Plotter::Mode::json ? "json" : "binary", per_frame_us(total),
+      plotter.dropped());
+  }
+
+  return 0;
+}
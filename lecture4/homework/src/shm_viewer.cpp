@@ -0,0 +1,89 @@
+#include <chrono>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "tools/shm_ring.hpp"
+
+using namespace std::chrono_literals;
+
+// 外部调试工具: 只读挂载main发布的共享内存, 显示或录制画面, 不影响发布端
+// 用法: ./shm_viewer [--name /sp_vision_frames] [--record 输出.avi] [--headless]
+int main(int argc, char ** argv)
+{
+  std::string name = "/sp_vision_frames", record_path;
+  bool headless = false;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--name" && i + 1 < argc) name = argv[++i];
+    else if (arg == "--record" && i + 1 < argc) record_path = argv[++i];
+    else if (arg == "--headless") headless = true;
+  }
+
+  std::unique_ptr<tools::ShmSubscriber> subscriber;
+  cv::VideoWriter writer;
+  uint64_t last_frame_id = -1, frames = 0, torn = 0;
+  auto last_report = std::chrono::steady_clock::now();
+  auto last_update = last_report;
+
+  while (true) {
+    // 发布端尚未启动或已重启时重新挂载
+    if (!subscriber || !subscriber->attached()) {
+      subscriber = std::make_unique<tools::ShmSubscriber>(name);
+      if (!subscriber->attached()) {
+        std::this_thread::sleep_for(500ms);
+        continue;
+      }
+      std::cout << "attached to " << name << std::endl;
+      last_update = std::chrono::steady_clock::now();
+    }
+
+    cv::Mat img;
+    tools::ShmFrameInfo info;
+    std::string result;
+    if (!subscriber->read_latest(img, info, result)) {
+      if (subscriber->published()) torn++;
+      std::this_thread::sleep_for(2ms);
+    } else if (info.frame_id != last_frame_id) {
+      last_frame_id = info.frame_id;
+      last_update = std::chrono::steady_clock::now();
+      frames++;
+
+      if (!record_path.empty()) {
+        if (!writer.isOpened())
+          writer.open(record_path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30, img.size());
+        writer.write(img);
+      }
+
+      if (!headless) {
+        // 结果文本逐行叠加在画面左上角
+        std::istringstream lines(result);
+        std::string line;
+        for (int y = 30; std::getline(lines, line); y += 25)
+          cv::putText(img, line, {10, y}, cv::FONT_HERSHEY_SIMPLEX, 0.6, {0, 255, 0}, 2);
+        cv::imshow(name, img);
+      }
+    }
+
+    if (!headless && cv::waitKey(1) == 'q') break;
+    if (headless) std::this_thread::sleep_for(2ms);
+
+    auto now = std::chrono::steady_clock::now();
+
+    // 长时间无新帧: 发布端可能已重启并重建了共享内存, 重新挂载
+    if (now - last_update > 2s) {
+      subscriber.reset();
+      last_update = now;
+    }
+
+    if (now - last_report > 1s) {
+      std::cout << frames << " fps, " << torn << " torn reads, frame " << last_frame_id << std::endl;
+      frames = torn = 0;
+      last_report = now;
+    }
+  }
+
+  return 0;
+}
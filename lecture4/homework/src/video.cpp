@@ -2,10 +2,72 @@
 #include <chrono>
 #include <nlohmann/json.hpp>
 #include <opencv2/opencv.hpp>
+#include "tools/pipeline.hpp"
 #include "tools/plotter.hpp"
-int main()
+#include "tools/video_source.hpp"
+#include "tools/visualizer.hpp"
+
+struct Detection
+{
+    cv::Mat img;
+    std::vector<auto_buff::FanBlade> fanblades;
+};
+
+static void draw_fanblades(cv::Mat & img, const std::vector<auto_buff::FanBlade> & fanblades)
+{
+    for (const auto& fanblade : fanblades) {
+        cv::Scalar color;
+        std::string type_name;
+        switch (fanblade.type) {
+            case auto_buff::_target:
+                color = cv::Scalar(0, 255, 0);  
+                type_name = "_target";
+                break;
+            case auto_buff::_light:
+                color = cv::Scalar(0, 255, 255); 
+                type_name = "_light";
+                break;
+            case auto_buff::_unlight:
+                color = cv::Scalar(0, 0, 255);  
+                type_name = "_unlight";
+                break;
+        }
+
+        // 绘制关键点
+        for (size_t i = 0; i < fanblade.points.size(); ++i) {
+            cv::circle(img, fanblade.points[i], 3, color, -1);
+            cv::putText(img, std::to_string(i), 
+                       cv::Point(fanblade.points[i].x + 5, fanblade.points[i].y - 5),
+                       cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 1);
+        }
+
+        // 绘制中心点
+        cv::circle(img, fanblade.center, 5, color, -1);
+        cv::putText(img, "CENTER", 
+                   cv::Point(fanblade.center.x + 10, fanblade.center.y - 10),
+                   cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 1);
+
+        // 绘制类型标签
+        cv::putText(img, type_name, 
+                   cv::Point(fanblade.center.x - 20, fanblade.center.y - 20),
+                   cv::FONT_HERSHEY_SIMPLEX, 0.7, color, 2);
+    }
+}
+
+//用法: ./video [--headless] [--workers N]
+//headless模式不显示画面, 用于测量检测器本身的吞吐
+int main(int argc, char ** argv)
 {
-    cv::VideoCapture cap("assets/test.avi"); 
+    bool headless = false;
+    int workers = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") headless = true;
+        else if (arg == "--workers" && i + 1 < argc) workers = std::stoi(argv[++i]);
+    }
+    
+    //多线程预解码, 解码不再占用检测循环的时间
+    tools::VideoSource cap("assets/test.avi", workers); 
     
     if (!cap.isOpened()) {
         std::cerr << "无法打开视频文件!" << std::endl;
@@ -14,74 +76,37 @@ int main()
     
     auto_buff::Buff_Detector detector;
     tools::Plotter plotter;
-    while(true){
+    std::unique_ptr<tools::Visualizer> visualizer;
+    if (!headless) visualizer = std::make_unique<tools::Visualizer>("Detection Results", 30);
+    
+    //评估检测器时不丢帧, 各阶段耗时由 report 给出
+    tools::Pipeline pipeline;
+    
+    auto frames = pipeline.source("video", [&]() -> std::optional<cv::Mat> {
         cv::Mat img;
-        cap >> img; 
-        
-        if (img.empty()) {
-            std::cout << "视频播放完毕或无法读取帧" << std::endl;
-            break;
-        }
-        
+        if (!cap.read(img)) return std::nullopt;  //视频播放完毕或无法读取帧
+        return img;
+    }, 4, tools::Backpressure::block);
+    
+    auto detections = pipeline.stage("detect", frames, [&](cv::Mat && img) {
         auto fanblades = detector.detect(img);
-        
-        cv::Mat display_img = img.clone();
-        for (const auto& fanblade : fanblades) {
-            cv::Scalar color;
-            std::string type_name;
-            switch (fanblade.type) {
-                case auto_buff::_target:
-                    color = cv::Scalar(0, 255, 0);  
-                    type_name = "_target";
-                    break;
-                case auto_buff::_light:
-                    color = cv::Scalar(0, 255, 255); 
-                    type_name = "_light";
-                    break;
-                case auto_buff::_unlight:
-                    color = cv::Scalar(0, 0, 255);  
-                    type_name = "_unlight";
-                    break;
-            }
-            
-            // 绘制关键点
-            for (size_t i = 0; i < fanblade.points.size(); ++i) {
-                cv::circle(display_img, fanblade.points[i], 3, color, -1);
-                cv::putText(display_img, std::to_string(i), 
-                           cv::Point(fanblade.points[i].x + 5, fanblade.points[i].y - 5),
-                           cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 1);
-            }
-            
-            // 绘制中心点
-            cv::circle(display_img, fanblade.center, 5, color, -1);
-            cv::putText(display_img, "CENTER", 
-                       cv::Point(fanblade.center.x + 10, fanblade.center.y - 10),
-                       cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 1);
-            
-            // 绘制类型标签
-            cv::putText(display_img, type_name, 
-                       cv::Point(fanblade.center.x - 20, fanblade.center.y - 20),
-                       cv::FONT_HERSHEY_SIMPLEX, 0.7, color, 2);
-        }
-        
-        // 显示检测结果
-        cv::resize(display_img,display_img,{},0.8,0.8);
-        cv::imshow("Detection Results", display_img);
-        if (cv::waitKey(30) == 27) { // 按ESC键退出
-            break;
-        }
-
+        return Detection{std::move(img), std::move(fanblades)};
+    });
+    
+    pipeline.sink("output", detections, [&](Detection && detection) {
         // plotjuggler
         nlohmann::json data;
-        if(fanblades.size())
-        {
-            data["fanblade_point"] = fanblades[0].points.size();
-        }
+        if (detection.fanblades.size()) data["fanblade_point"] = detection.fanblades[0].points.size();
         plotter.plot(data);
-
-    }
+        
+        if (!visualizer) return;
+        visualizer->submit(detection.img, [fanblades = detection.fanblades](cv::Mat & canvas) {
+            draw_fanblades(canvas, fanblades);
+        });
+        if (visualizer->key() == 27) pipeline.stop();  //按ESC键退出
+    });
     
-    cap.release();
-    cv::destroyAllWindows();
+    pipeline.run();
+    pipeline.report();
     return 0;
-}
\ No newline at end of file
+}
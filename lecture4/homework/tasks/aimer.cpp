@@ -0,0 +1,37 @@
+#include "aimer.hpp"
+
+namespace auto_buff
+{
+Aimer::Aimer(double delay, const tools::BallisticTable::Params & params, const std::string & cache_dir)
+: delay_(delay), table_(params, cache_dir)
+{
+}
+
+AimCommand Aimer::aim(const Eigen::Vector3d & xyz) const
+{
+  return aim_moving([&xyz](double) { return xyz; });
+}
+
+AimCommand Aimer::aim(const cv::Point3f & xyz_mm) const
+{
+  return aim(Eigen::Vector3d(xyz_mm.x, xyz_mm.y, xyz_mm.z) / 1e3);
+}
+
+std::optional<tools::BallisticTable::Solution> Aimer::solve(
+  const Eigen::Vector3d & xyz, AimCommand & command) const
+{
+  auto d = std::sqrt(xyz[0] * xyz[0] + xyz[2] * xyz[2]);
+  auto h = -xyz[1];
+
+  auto solution = table_.lookup(d, h);
+  command.control = solution.has_value();
+  if (!solution) return std::nullopt;
+
+  command.yaw = std::atan2(xyz[0], xyz[2]);
+  command.pitch = solution->pitch;
+  command.fly_time = solution->fly_time;
+  command.aim_xyz = xyz;
+  return solution;
+}
+
+}  // namespace auto_buff
@@ -0,0 +1,71 @@
+#ifndef AUTO_BUFF__AIMER_HPP
+#define AUTO_BUFF__AIMER_HPP
+
+#include <Eigen/Dense>
+#include <cmath>
+#include <opencv2/opencv.hpp>
+#include <optional>
+
+#include "tools/ballistic_table.hpp"
+
+namespace auto_buff
+{
+struct AimCommand
+{
+  bool control = false;  // false: 目标超出弹道表范围或不可达
+  double yaw = 0;        // 向右为正, 单位: rad
+  double pitch = 0;      // 向上为正, 单位: rad
+  double fly_time = 0;   // 单位: s
+  Eigen::Vector3d aim_xyz = Eigen::Vector3d::Zero();  // 最终瞄准点(相机系), 单位: m
+  int iterations = 0;
+};
+
+// 弹道解算: 目标位置 -> 云台 yaw/pitch
+// 坐标均为相机系(x右, y下, z前), 单位: m; 暂未考虑相机与枪管之间的外参
+class Aimer
+{
+public:
+  // delay: 从拍照到弹丸出膛的系统延迟, 单位: s
+  explicit Aimer(
+    double delay = 0.05, const tools::BallisticTable::Params & params = {},
+    const std::string & cache_dir = "cache");
+
+  // 静止目标, 如 Buff_Solver 解算出的点(单位: mm) 或装甲板 tvec(单位: m)
+  AimCommand aim(const Eigen::Vector3d & xyz) const;
+  AimCommand aim(const cv::Point3f & xyz_mm) const;
+
+  // 运动目标: predict(dt) 返回 dt 秒后目标的位置
+  // 迭代 "预测 -> 查表得飞行时间 -> 再预测", 直到飞行时间收敛
+  template <typename PREDICT>
+  AimCommand aim_moving(PREDICT && predict) const
+  {
+    AimCommand command;
+    double t = delay_;
+
+    for (command.iterations = 1; command.iterations <= MAX_ITERATIONS; command.iterations++) {
+      Eigen::Vector3d xyz = predict(t);
+      auto solution = solve(xyz, command);
+      if (!solution) return command;
+
+      auto next_t = delay_ + solution->fly_time;
+      if (std::abs(next_t - t) < TIME_TOLERANCE) break;
+      t = next_t;
+    }
+
+    return command;
+  }
+
+private:
+  static constexpr int MAX_ITERATIONS = 10;
+  static constexpr double TIME_TOLERANCE = 1e-3;  // s
+
+  double delay_;
+  tools::BallisticTable table_;
+
+  std::optional<tools::BallisticTable::Solution> solve(
+    const Eigen::Vector3d & xyz, AimCommand & command) const;
+};
+
+}  // namespace auto_buff
+
+#endif  // AUTO_BUFF__AIMER_HPP
@@ -1,23 +1,95 @@
 #include "buff_detector.hpp"
 
+#include <algorithm>
 
 namespace auto_buff
 {
-Buff_Detector::Buff_Detector() : MODE_() {}
+// 灯臂采样范围: 扇叶中心沿指向R标方向 200~550mm(扇叶半高150mm, R标距扇叶中心700mm)
+static const float ARM_BEGIN = 200.0f, ARM_END = 550.0f;
+static const int ARM_SAMPLES = 32;
+// 采样点在垂直灯臂方向 ±20mm 内任一像素亮起即算亮起, 容忍关键点误差
+static const float ARM_HALF_WIDTH = 20.0f;
+// 低曝光下灯条接近饱和, 背景与未亮的灯条很暗
+static const int ARM_LIT_THRESHOLD = 100;
+// 灯臂亮起比例: 低于 UNLIGHT 视为未点亮, 不低于 LIGHT 视为已激活, 其间为流水灯箭头(待击打)
+static const double UNLIGHT_RATIO = 0.15, LIGHT_RATIO = 0.75;
 
+Buff_Detector::Buff_Detector(bool refine_keypoints) : MODE_(refine_keypoints) {}
 
-std::vector<FanBlade> Buff_Detector::detect(cv::Mat & bgr_img)
+
+std::vector<FanBlade> Buff_Detector::detect(const cv::Mat & bgr_img)
 {
+  start(bgr_img);
+  return wait();
+}
 
-  std::vector<YOLO11_BUFF::Object> results = MODE_.get_onecandidatebox(bgr_img);
+void Buff_Detector::start(const cv::Mat & bgr_img)
+{
+  pending_img_ = bgr_img;
+  MODE_.start_multicandidateboxes(bgr_img);
+}
+
+std::vector<FanBlade> Buff_Detector::wait()
+{
+  const cv::Mat bgr_img = std::move(pending_img_);
+  std::vector<YOLO11_BUFF::Object> results = MODE_.wait_multicandidateboxes();
   if (results.empty()) {
     return std::vector<FanBlade>();
   }
 
+  // 一帧中至多一个待击打扇叶, 取置信度最高的(results 已按置信度排序)
   std::vector<FanBlade> fanblades;
-  auto result = results[0];
-  fanblades.emplace_back(FanBlade(result.kpt, result.kpt[4], _light));
+  bool has_target = false;
+  for (const auto & result : results) {
+    FanBlade fanblade(result.kpt, result.kpt[4], _light);
+    auto ratio = arm_lit_ratio(fanblade, bgr_img);
+    if (ratio < UNLIGHT_RATIO) {
+      fanblade.type = _unlight;
+    } else if (ratio < LIGHT_RATIO && !has_target) {
+      fanblade.type = _target;
+      has_target = true;
+    }
+    fanblades.push_back(fanblade);
+  }
 
+  // 待击打扇叶放在最前, 解算时作为参考扇叶
+  std::stable_partition(
+    fanblades.begin(), fanblades.end(), [](const FanBlade & b) { return b.type == _target; });
   return fanblades;
 }
-}  // namespace auto_buff
\ No newline at end of file
+
+double Buff_Detector::arm_lit_ratio(const FanBlade & fanblade, const cv::Mat & bgr_img) const
+{
+  // 关键点0~3为扇叶四角, 2、3靠近R标, 两条边的中点相距扇叶高度300mm
+  const auto & p = fanblade.points;
+  cv::Point2f towards_r = (p[2] + p[3] - p[0] - p[1]) * 0.5f;
+  float length = cv::norm(towards_r);
+  if (length < 1.0f) return 0;
+  float pixel_per_mm = length / 300.0f;
+  towards_r *= 1.0f / length;
+  cv::Point2f across(-towards_r.y, towards_r.x);
+  int half_width = std::max(1, cvRound(ARM_HALF_WIDTH * pixel_per_mm));
+  cv::Rect bounds(0, 0, bgr_img.cols, bgr_img.rows);
+
+  int lit = 0, inside = 0;
+  for (int i = 0; i < ARM_SAMPLES; ++i) {
+    float mm = ARM_BEGIN + (ARM_END - ARM_BEGIN) * i / (ARM_SAMPLES - 1);
+    cv::Point2f sample = fanblade.center + towards_r * (mm * pixel_per_mm);
+    if (!bounds.contains(sample)) continue;
+    inside++;
+    for (int d = -half_width; d <= half_width; ++d) {
+      cv::Point point = sample + across * float(d);
+      if (!bounds.contains(point)) continue;
+      const auto & bgr = bgr_img.at<cv::Vec3b>(point);
+      if (std::max({bgr[0], bgr[1], bgr[2]}) > ARM_LIT_THRESHOLD) {
+        lit++;
+        break;
+      }
+    }
+  }
+
+  // 灯臂大半在画面外时无法判断, 按已激活处理
+  if (inside < ARM_SAMPLES / 2) return 1;
+  return double(lit) / inside;
+}
+}  // namespace auto_buff
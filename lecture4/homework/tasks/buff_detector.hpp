@@ -9,11 +9,25 @@ namespace auto_buff
 class Buff_Detector
 {
 public:
-  Buff_Detector();
-  std::vector<FanBlade> detect(cv::Mat & bgr_img);
+  // refine_keypoints: 是否对网络输出的关键点做亚像素精修
+  explicit Buff_Detector(bool refine_keypoints = false);
+  // 返回所有检测到的扇叶, 按灯臂亮起的比例分为 _target/_light/_unlight, _target 在最前
+  std::vector<FanBlade> detect(const cv::Mat & bgr_img);
+  // detect 拆为两步, 多台相机各用一个检测器时先全部 start 再依次 wait, 推理并行进行
+  void start(const cv::Mat & bgr_img);
+  std::vector<FanBlade> wait();
+  void warmup(int times = 3) { MODE_.warmup(times); }
+  // 低置信度的检测交给困难样本收集器
+  void set_harvester(std::shared_ptr<tools::Harvester> harvester)
+  {
+    MODE_.set_harvester(std::move(harvester));
+  }
 private:
   cv::Point2f get_r_center(std::vector<FanBlade> & fanblades, cv::Mat & bgr_img);
+  // 扇叶中心与R标之间的灯臂上亮起的采样点比例
+  double arm_lit_ratio(const FanBlade & fanblade, const cv::Mat & bgr_img) const;
   YOLO11_BUFF MODE_;
+  cv::Mat pending_img_;
 };
 }  // namespace auto_buff
 #endif  // DETECTOR_HPP
\ No newline at end of file
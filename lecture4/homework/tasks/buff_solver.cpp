@@ -1,9 +1,14 @@
 #include "buff_solver.hpp"
 #include <eigen3/Eigen/Dense>
+#include <algorithm>
 #include <cmath>
 
 namespace auto_buff
 {
+//能量机关几何: 5片扇叶均布, 扇叶中心距R标700mm
+//能量机关坐标系原点在R标, 0号扇叶位于正上方(-y), 扇叶坐标系y轴指向R标
+static const int BLADE_NUM = 5;
+static const float RUNE_RADIUS = 700.0f;
 
 Buff_Solver::Buff_Solver()
 {
@@ -11,6 +16,14 @@ Buff_Solver::Buff_Solver()
     initModelPoints();
 }
 
+Buff_Solver::Buff_Solver(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs,
+                         const cv::Matx33d& R_camera2ref, const cv::Vec3d& t_camera2ref)
+: camera_matrix_(camera_matrix.clone()), dist_coeffs_(dist_coeffs.clone()),
+  R_camera2ref_(R_camera2ref), t_camera2ref_(t_camera2ref)
+{
+    initModelPoints();
+}
+
 void Buff_Solver::initCameraParams()
 {
     //相机参数
@@ -50,20 +63,32 @@ void Buff_Solver::initModelPoints()
 
 cv::Point3f Buff_Solver::solveFanbladeCenter(const FanBlade& fanblade)
 {
-    if (fanblade.points.size() < 5) {
+    auto pose = solveFanbladePose(fanblade);
+    if (!pose.valid) {
         return cv::Point3f(0, 0, 0);
     }
+    return pose.center;
+}
+
+FanbladePose Buff_Solver::solveFanbladePose(const FanBlade& fanblade)
+{
+    FanbladePose pose;
+    if (fanblade.points.size() < 5) {
+        return pose;
+    }
     
     //生成2D图像点
     std::vector<cv::Point2f> image_points;
+    std::vector<cv::Point3f> object_points;
     for (size_t i = 0; i < fanblade.points.size() && i < model_points_3d_.size(); ++i) {
         image_points.push_back(fanblade.points[i]);
+        object_points.push_back(model_points_3d_[i]);
     }
     
     //PnP求解
     cv::Mat rvec, tvec;
     bool success = cv::solvePnP(
-        model_points_3d_,
+        object_points,
         image_points,
         camera_matrix_,
         dist_coeffs_,
@@ -74,11 +99,20 @@ cv::Point3f Buff_Solver::solveFanbladeCenter(const FanBlade& fanblade)
     );
     
     if (!success) {
-        return cv::Point3f(0, 0, 0);
+        return pose;
     }
     
+    //重投影误差与协方差(复用一次projectPoints的雅可比)
+    auto quality = tools::evaluate_pnp(object_points, image_points, camera_matrix_, dist_coeffs_, rvec, tvec);
+    
     //得出扇叶中心在相机坐标系下的3D位置
-    return cv::Point3f(tvec.at<double>(0), tvec.at<double>(1), tvec.at<double>(2));
+    pose.center = cv::Point3f(tvec.at<double>(0), tvec.at<double>(1), tvec.at<double>(2));
+    pose.rvec = rvec;
+    pose.tvec = tvec;
+    pose.reprojection_rms = quality.reprojection_rms;
+    pose.covariance = quality.covariance;
+    pose.valid = quality.reprojection_rms <= max_reprojection_rms_;
+    return pose;
 }
 
 cv::Point3f Buff_Solver::solveRotationCenter(const std::vector<cv::Point3f>& fanblade_centers)
@@ -119,4 +153,154 @@ cv::Point3f Buff_Solver::solveRotationCenter(const std::vector<cv::Point3f>& fan
     return cv::Point3f(center(0), center(1), center(2));
 }
 
-}  
\ No newline at end of file
+cv::Point3f Buff_Solver::runeBladeCenter(int k) const
+{
+    double angle = k * 2 * CV_PI / BLADE_NUM;
+    return cv::Point3f(RUNE_RADIUS * std::sin(angle), -RUNE_RADIUS * std::cos(angle), 0);
+}
+
+std::vector<cv::Point3f> Buff_Solver::runeModelPoints(int k) const
+{
+    double angle = k * 2 * CV_PI / BLADE_NUM;
+    float c = std::cos(angle), s = std::sin(angle);
+    
+    std::vector<cv::Point3f> points;
+    for (const auto& p : model_points_3d_) {
+        //先平移到0号扇叶位置, 再绕z轴旋转
+        float x = p.x, y = p.y - RUNE_RADIUS;
+        points.push_back(cv::Point3f(c * x - s * y, s * x + c * y, 0));
+    }
+    return points;
+}
+
+PowerRunePose Buff_Solver::solvePowerRune(const std::vector<FanBlade>& fanblades)
+{
+    PowerRunePose pose;
+    
+    std::vector<const FanBlade*> blades;
+    for (const auto& fanblade : fanblades) {
+        if (fanblade.points.size() >= model_points_3d_.size()) blades.push_back(&fanblade);
+    }
+    if (blades.empty()) return pose;
+    
+    //参考扇叶(优先_target)定义为0号扇叶
+    std::stable_partition(blades.begin(), blades.end(), [](const FanBlade* b) { return b->type == _target; });
+    auto image_points_of = [this](const FanBlade& b) {
+        return std::vector<cv::Point2f>(b.points.begin(), b.points.begin() + model_points_3d_.size());
+    };
+    
+    //1. 参考扇叶单独PnP作为初值
+    cv::Mat rvec, tvec;
+    if (!cv::solvePnP(runeModelPoints(0), image_points_of(*blades[0]), camera_matrix_, dist_coeffs_,
+                      rvec, tvec, false, cv::SOLVEPNP_IPPE)) {
+        return pose;
+    }
+    
+    //2. 把其余扇叶分配到最近的槽位, 距离超过相邻槽位间距一半的视为误检, 不参与解算
+    std::vector<cv::Point3f> slot_centers;
+    for (int k = 0; k < BLADE_NUM; ++k) slot_centers.push_back(runeBladeCenter(k));
+    std::vector<cv::Point2f> projected_slots;
+    cv::projectPoints(slot_centers, rvec, tvec, camera_matrix_, dist_coeffs_, projected_slots);
+    double slot_spacing = 1e10;
+    for (int k = 0; k < BLADE_NUM; ++k) {
+        slot_spacing = std::min(slot_spacing, cv::norm(projected_slots[k] - projected_slots[(k + 1) % BLADE_NUM]));
+    }
+    
+    std::vector<std::pair<int, const FanBlade*>> members = {{0, blades[0]}};  //(槽位, 扇叶)
+    std::vector<bool> used(BLADE_NUM, false);
+    used[0] = true;
+    
+    for (size_t i = 1; i < blades.size(); ++i) {
+        int best_k = -1;
+        double min_distance = 0.5 * slot_spacing;
+        for (int k = 1; k < BLADE_NUM; ++k) {
+            double distance = cv::norm(projected_slots[k] - blades[i]->center);
+            if (!used[k] && distance < min_distance) {
+                min_distance = distance;
+                best_k = k;
+            }
+        }
+        if (best_k < 0) continue;
+        
+        used[best_k] = true;
+        members.emplace_back(best_k, blades[i]);
+    }
+    
+    //3. 所有扇叶的点一起做LM迭代(重投影误差最小二乘)
+    //   重投影误差超限时剔除残差最大的非参考扇叶后重解, 只剩参考扇叶时即为其单独PnP的结果
+    const size_t points_per_blade = model_points_3d_.size();
+    const cv::Mat initial_rvec = rvec.clone(), initial_tvec = tvec.clone();
+    std::vector<cv::Point3f> object_points;
+    std::vector<cv::Point2f> image_points;
+    tools::PnPQuality quality;
+    while (true) {
+        object_points.clear();
+        image_points.clear();
+        for (const auto& member : members) {
+            auto model_points = runeModelPoints(member.first);
+            auto points = image_points_of(*member.second);
+            object_points.insert(object_points.end(), model_points.begin(), model_points.end());
+            image_points.insert(image_points.end(), points.begin(), points.end());
+        }
+        
+        rvec = initial_rvec.clone();
+        tvec = initial_tvec.clone();
+        if (members.size() > 1) {
+            cv::solvePnP(object_points, image_points, camera_matrix_, dist_coeffs_,
+                         rvec, tvec, true, cv::SOLVEPNP_ITERATIVE);
+        }
+        quality = tools::evaluate_pnp(object_points, image_points, camera_matrix_, dist_coeffs_, rvec, tvec);
+        if (quality.reprojection_rms <= max_reprojection_rms_ || members.size() == 1) break;
+        
+        std::vector<cv::Point2f> projected;
+        cv::projectPoints(object_points, rvec, tvec, camera_matrix_, dist_coeffs_, projected);
+        size_t worst = 1;
+        double worst_error = -1;
+        for (size_t m = 1; m < members.size(); ++m) {
+            double error = 0;
+            for (size_t j = m * points_per_blade; j < (m + 1) * points_per_blade; ++j) {
+                error += cv::norm(projected[j] - image_points[j]);
+            }
+            if (error > worst_error) {
+                worst_error = error;
+                worst = m;
+            }
+        }
+        members.erase(members.begin() + worst);
+    }
+    
+    pose.blade_count = members.size();
+    pose.reprojection_rms = quality.reprojection_rms;
+    pose.covariance = quality.covariance;
+    if (quality.reprojection_rms > max_reprojection_rms_) {
+        return pose;
+    }
+    
+    //换算到基准相机系, 单相机时不变
+    cv::Mat rmat;
+    cv::Rodrigues(rvec, rmat);
+    cv::Matx33d R = R_camera2ref_ * cv::Matx33d(rmat);
+    cv::Vec3d t = R_camera2ref_ * cv::Vec3d(tvec.at<double>(0), tvec.at<double>(1), tvec.at<double>(2)) + t_camera2ref_;
+    cv::Rodrigues(cv::Mat(R), rvec);
+    tvec = (cv::Mat_<double>(3, 1) << t[0], t[1], t[2]);
+    
+    cv::Vec3d normal = R * cv::Vec3d(0, 0, 1);
+    cv::Vec3d blade_dir = R * cv::Vec3d(0, -1, 0);
+    cv::Vec3d target_center = t + R * cv::Vec3d(0, -RUNE_RADIUS, 0);
+    
+    //相位: 画面竖直向上方向投影到机关平面后, 与参考扇叶方向的夹角
+    cv::Vec3d up(0, -1, 0);
+    up -= up.dot(normal) * normal;
+    
+    pose.valid = true;
+    pose.has_target = blades[0]->type == _target;
+    pose.center = cv::Point3f(t[0], t[1], t[2]);
+    pose.target_center = cv::Point3f(target_center[0], target_center[1], target_center[2]);
+    pose.normal = cv::Vec3f(normal[0], normal[1], normal[2]);
+    pose.phase = std::atan2(up.cross(blade_dir).dot(normal), up.dot(blade_dir));
+    pose.rvec = rvec;
+    pose.tvec = tvec;
+    return pose;
+}
+
+}
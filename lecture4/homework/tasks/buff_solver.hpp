@@ -4,28 +4,76 @@
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include "buff_type.hpp"
+#include "tools/pnp_tools.hpp"
 
 namespace auto_buff
 {
+//单个扇叶的位姿(相机系, 单位: mm)
+struct FanbladePose
+{
+    bool valid = false;          //PnP失败或重投影误差超过阈值时为false
+    cv::Point3f center;          //扇叶中心
+    cv::Mat rvec, tvec;          //扇叶坐标系 -> 相机系
+    double reprojection_rms = 0; //单位: pixel
+    cv::Matx66d covariance;      //[rvec, tvec]的近似协方差
+};
+
+//能量机关整体位姿(相机系, 多相机时为基准相机系, 单位: mm)
+struct PowerRunePose
+{
+    bool valid = false;
+    bool has_target = false;     //参考扇叶是否为待击打扇叶(_target), 否则不应瞄准
+    cv::Point3f center;          //R标(旋转中心)
+    cv::Point3f target_center;   //参考扇叶中心(优先取_target)
+    cv::Vec3f normal;            //能量机关平面法向
+    double phase = 0;            //参考扇叶相对画面竖直向上方向的转角, 单位: rad
+    cv::Mat rvec, tvec;          //能量机关坐标系 -> 相机系
+    int blade_count = 0;         //参与解算的扇叶数
+    double reprojection_rms = 0; //单位: pixel
+    cv::Matx66d covariance;      //[rvec, tvec]的近似协方差, 在拍摄该帧的相机系下
+};
+
 class Buff_Solver
 {
 public:
     Buff_Solver();
     
+    //多相机时每台相机一个解算器: 该相机的内参, 以及该相机系到基准相机系的变换(单位: mm)
+    //solvePowerRune 的结果换算到基准相机系, 各相机的结果可直接比较
+    Buff_Solver(const cv::Mat& camera_matrix, const cv::Mat& dist_coeffs,
+                const cv::Matx33d& R_camera2ref = cv::Matx33d::eye(), const cv::Vec3d& t_camera2ref = cv::Vec3d());
+    
     //解算扇叶中心的位置
     cv::Point3f solveFanbladeCenter(const FanBlade& fanblade);
     
+    //解算扇叶位姿, 附带重投影误差与协方差
+    FanbladePose solveFanbladePose(const FanBlade& fanblade);
+    
     //推算算能灵中心
     cv::Point3f solveRotationCenter(const std::vector<cv::Point3f>& fanblade_centers);
+    
+    //用一帧内所有扇叶联合解算能量机关位姿(一次非线性最小二乘)
+    PowerRunePose solvePowerRune(const std::vector<FanBlade>& fanblades);
 
 private:
     //相机参数
     cv::Mat camera_matrix_;
     cv::Mat dist_coeffs_;
     
+    //本相机系 -> 基准相机系, 单相机时为单位变换
+    cv::Matx33d R_camera2ref_ = cv::Matx33d::eye();
+    cv::Vec3d t_camera2ref_;
+    
     //扇叶的模型点
     std::vector<cv::Point3f> model_points_3d_;
     
+    //重投影RMS超过该值的解视为不可信, 单位: pixel
+    double max_reprojection_rms_ = 3.0;
+    
+    //第k号扇叶的模型点在能量机关坐标系下的坐标
+    std::vector<cv::Point3f> runeModelPoints(int k) const;
+    cv::Point3f runeBladeCenter(int k) const;
+    
     //初始化
     void initCameraParams();
     void initModelPoints();
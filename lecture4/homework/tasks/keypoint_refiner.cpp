@@ -0,0 +1,73 @@
+#include "keypoint_refiner.hpp"
+
+namespace auto_buff
+{
+KeypointRefiner::KeypointRefiner(int half_window, int max_points, float max_shift)
+: half_window_(half_window), max_points_(max_points), max_shift_(max_shift), budget_(0)
+{
+}
+
+int KeypointRefiner::refine(const cv::Mat & bgr_img, std::vector<cv::Point2f> & keypoints)
+{
+  if (bgr_img.empty()) return 0;
+
+  int refined = 0;
+  for (size_t i = 0; i < keypoints.size() && budget_ > 0; i++) {
+    budget_--;
+    auto ok = (i < 4) ? refine_corner(bgr_img, keypoints[i]) : refine_centroid(bgr_img, keypoints[i]);
+    if (ok) refined++;
+  }
+  return refined;
+}
+
+// 只对小块做灰度化, 整帧不做任何转换
+bool KeypointRefiner::crop_gray(const cv::Mat & bgr_img, const cv::Point2f & point, cv::Rect & roi)
+{
+  // 多留2px, cornerSubPix 计算梯度时需要窗口外一圈像素
+  auto border = half_window_ + 2;
+  roi = cv::Rect(cvRound(point.x) - border, cvRound(point.y) - border, 2 * border + 1, 2 * border + 1);
+  if ((roi & cv::Rect(0, 0, bgr_img.cols, bgr_img.rows)) != roi) return false;
+
+  cv::cvtColor(bgr_img(roi), patch_gray_, cv::COLOR_BGR2GRAY);
+  return true;
+}
+
+bool KeypointRefiner::refine_corner(const cv::Mat & bgr_img, cv::Point2f & point)
+{
+  cv::Rect roi;
+  if (!crop_gray(bgr_img, point, roi)) return false;
+
+  std::vector<cv::Point2f> corner = {point - cv::Point2f(roi.x, roi.y)};
+  cv::cornerSubPix(
+    patch_gray_, corner, cv::Size(half_window_, half_window_), cv::Size(-1, -1),
+    cv::TermCriteria(cv::TermCriteria::EPS + cv::TermCriteria::COUNT, 10, 0.01));
+
+  auto refined = corner[0] + cv::Point2f(roi.x, roi.y);
+  if (cv::norm(refined - point) > max_shift_) return false;
+
+  point = refined;
+  return true;
+}
+
+bool KeypointRefiner::refine_centroid(const cv::Mat & bgr_img, cv::Point2f & point)
+{
+  cv::Rect roi;
+  if (!crop_gray(bgr_img, point, roi)) return false;
+
+  // 以小块均值为基准, 只让比背景亮的像素参与加权
+  patch_gray_.convertTo(patch_float_, CV_32F);
+  auto mean = cv::mean(patch_float_)[0];
+  cv::subtract(patch_float_, mean, patch_float_);
+  cv::max(patch_float_, 0, patch_float_);
+
+  auto m = cv::moments(patch_float_);
+  if (m.m00 < 1e-3) return false;
+
+  auto refined = cv::Point2f(m.m10 / m.m00 + roi.x, m.m01 / m.m00 + roi.y);
+  if (cv::norm(refined - point) > max_shift_) return false;
+
+  point = refined;
+  return true;
+}
+
+}  // namespace auto_buff
@@ -0,0 +1,42 @@
+#ifndef AUTO_BUFF__KEYPOINT_REFINER_HPP
+#define AUTO_BUFF__KEYPOINT_REFINER_HPP
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace auto_buff
+{
+// 关键点亚像素精修: 网络输出在640x640网格上, 还原到原图后有约2px的量化误差
+// 在原图上截取关键点附近的小块, 角点用 cornerSubPix, 中心点用亮度质心
+class KeypointRefiner
+{
+public:
+  // half_window: 截取窗口的半径, 单位: pixel
+  // max_points: 每帧最多精修的点数, 超出的点保持网络输出
+  // max_shift: 精修后偏移超过该值则认为失败, 保持网络输出, 单位: pixel
+  KeypointRefiner(int half_window = 5, int max_points = 12, float max_shift = 3.0f);
+
+  // 每帧开始时调用一次, 重置本帧的精修点数
+  void begin_frame() { budget_ = max_points_; }
+
+  // keypoints 顺序同 Buff_Solver 的模型点: 0~3为角点, 4为扇叶中心, 5为中心上方的点
+  // 同一帧内多次调用共用 begin_frame 给出的点数, 用完后其余点保持网络输出
+  // 返回成功精修的点数
+  int refine(const cv::Mat & bgr_img, std::vector<cv::Point2f> & keypoints);
+
+private:
+  int half_window_;
+  int max_points_;
+  float max_shift_;
+  int budget_;  // 本帧剩余的可精修点数
+
+  cv::Mat patch_gray_, patch_float_;  // 复用缓冲区, 避免每帧分配
+
+  bool crop_gray(const cv::Mat & bgr_img, const cv::Point2f & point, cv::Rect & roi);
+  bool refine_corner(const cv::Mat & bgr_img, cv::Point2f & point);
+  bool refine_centroid(const cv::Mat & bgr_img, cv::Point2f & point);
+};
+
+}  // namespace auto_buff
+
+#endif  // AUTO_BUFF__KEYPOINT_REFINER_HPP
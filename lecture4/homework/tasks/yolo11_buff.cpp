@@ -1,129 +1,146 @@
 #include "yolo11_buff.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+#include "tools/logger.hpp"
+#include "tools/thread_config.hpp"
+
 const double ConfidenceThreshold = 0.7f;
 const double IouThreshold = 0.4f;
 namespace auto_buff
 {
-YOLO11_BUFF::YOLO11_BUFF()
+YOLO11_BUFF::YOLO11_BUFF(bool refine_keypoints, const BuffModelConfig & model_config)
+: input_size_(model_config.input_size),
+  refine_keypoints_(refine_keypoints),
+  harvest_confidence_(0.85f)
 {
-  model = core.read_model("assets/yolo11_buff_int8.xml");
-  compiled_model = core.compile_model(model, "CPU");
+  auto begin = std::chrono::steady_clock::now();
+  model = core.read_model(model_config.model_path);
+  model->reshape({1, 3, input_size_, input_size_});
+  auto read_end = std::chrono::steady_clock::now();
+
+  // 编译结果缓存在磁盘上, 重启后直接导入, 省去数秒的编译
+  if (!model_config.cache_dir.empty()) core.set_property(ov::cache_dir(model_config.cache_dir));
+
+  // 推理线程数与可用核心来自线程配置, 避免OpenVINO线程池占满所有核心与相机/控制线程争抢
+  // CPU插件按编译时调用线程的亲和性确定可用核心, 故编译期间临时绑定到推理核心
+  auto inference = tools::inference_config();
+  ov::AnyMap config;
+  auto threads = model_config.threads > 0 ? model_config.threads : inference.threads;
+  if (threads > 0) config.emplace(ov::inference_num_threads(threads));
+  if (!inference.cpus.empty()) config.emplace(ov::hint::enable_cpu_pinning(true));
+  if (model_config.streams > 0) config.emplace(ov::num_streams(model_config.streams));
+
+  const static std::map<std::string, ov::element::Type> precisions = {
+    {"f32", ov::element::f32}, {"f16", ov::element::f16}, {"bf16", ov::element::bf16}};
+  if (precisions.count(model_config.precision))
+    config.emplace(ov::hint::inference_precision(precisions.at(model_config.precision)));
+  else if (!model_config.precision.empty())
+    throw std::runtime_error("Unknown inference precision: " + model_config.precision);
+
+  // 编译后缓存目录中多出文件说明未命中缓存
+  auto cache_files = [&model_config] {
+    std::error_code ec;
+    if (model_config.cache_dir.empty() || !std::filesystem::is_directory(model_config.cache_dir, ec))
+      return 0;
+    int count = 0;
+    for (auto it = std::filesystem::directory_iterator(model_config.cache_dir, ec);
+         it != std::filesystem::directory_iterator(); it.increment(ec))
+      count++;
+    return count;
+  };
+  auto cached = cache_files();
+  {
+    tools::ScopedAffinity affinity(inference.cpus);
+    compiled_model = core.compile_model(model, "CPU", config);
+  }
+  auto compile_end = std::chrono::steady_clock::now();
+  auto start = model_config.cache_dir.empty() ? "no cache"
+               : cache_files() > cached       ? "cold start"
+                                              : "warm start";
+
+  tools::logger()->info(
+    "YOLO11_BUFF {}: read {:.0f} ms, compile {:.0f} ms ({})", model_config.model_path,
+    std::chrono::duration<double, std::milli>(read_end - begin).count(),
+    std::chrono::duration<double, std::milli>(compile_end - read_end).count(), start);
+
   infer_request = compiled_model.create_infer_request();
   input_tensor = infer_request.get_input_tensor();
-  input_tensor.set_shape({1, 3, 640, 640});
+  input_tensor.set_shape({1, 3, size_t(input_size_), size_t(input_size_)});
 }
 
-std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::get_multicandidateboxes(cv::Mat & image)
+std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::get_multicandidateboxes(const cv::Mat & image)
 {
-  const int64 start = cv::getTickCount();  
-
-  if (image.empty()) {
-    return std::vector<YOLO11_BUFF::Object> ();
-  }
-
-  cv::Mat bgr_img = image;
-
-  auto x_scale = static_cast<double>(640) / bgr_img.rows;
-  auto y_scale = static_cast<double>(640) / bgr_img.cols;
-  auto scale = std::min(x_scale, y_scale);
-  auto h = static_cast<int>(bgr_img.rows * scale);
-  auto w = static_cast<int>(bgr_img.cols * scale);
-
-  double factor = scale;  
-
-  auto input = cv::Mat(640, 640, CV_8UC3, cv::Scalar(0, 0, 0));
-  auto roi = cv::Rect(0, 0, w, h);
-  cv::resize(bgr_img, input(roi), {w, h});
-  ov::Tensor input_tensor(ov::element::u8, {1, 640, 640, 3}, input.data);
+  start_multicandidateboxes(image);
+  return wait_multicandidateboxes();
+}
 
+void YOLO11_BUFF::start_multicandidateboxes(const cv::Mat & image)
+{
+  pending_image_ = image;
+  if (image.empty()) return;
 
-  infer_request.infer();
+  // 写入与 infer_request 绑定的输入张量, 与 get_onecandidatebox 的预处理一致
+  pending_factor_ = fill_tensor_data_image(input_tensor, image);
+  infer_request.start_async();
+}
 
+std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::wait_multicandidateboxes()
+{
+  const cv::Mat image = std::move(pending_image_);
+  if (image.empty()) {
+    return std::vector<YOLO11_BUFF::Object>();
+  }
 
-  const ov::Tensor output = infer_request.get_output_tensor();  
+  infer_request.wait();
+  const float factor = pending_factor_;
+  const ov::Tensor output = infer_request.get_output_tensor();
   const ov::Shape output_shape = output.get_shape();
   const float * output_buffer = output.data<const float>();
-  const int out_rows = output_shape[1];  
-  const int out_cols = output_shape[2];  
+  const int out_rows = output_shape[1];
+  const int out_cols = output_shape[2];
   const cv::Mat det_output(
-    out_rows, out_cols, CV_32F, (float *)output_buffer);  
-  std::vector<cv::Rect> boxes;                          
-  std::vector<float> confidences;                       
-  std::vector<std::vector<float>> objects_keypoints;     
+    out_rows, out_cols, CV_32F, (float *)output_buffer);
 
+  std::vector<cv::Rect> boxes;
+  std::vector<float> confidences;
+  std::vector<int> candidates;
   for (int i = 0; i < det_output.cols; ++i) {
     const float score = det_output.at<float>(4, i);
     if (score > ConfidenceThreshold) {
-      const float cx = det_output.at<float>(0, i);
-      const float cy = det_output.at<float>(1, i);
-      const float ow = det_output.at<float>(2, i);
-      const float oh = det_output.at<float>(3, i);
-      cv::Rect box;
-      box.x = static_cast<int>((cx - 0.5 * ow) * factor);
-      box.y = static_cast<int>((cy - 0.5 * oh) * factor);
-      box.width = static_cast<int>(ow * factor);
-      box.height = static_cast<int>(oh * factor);
-      boxes.push_back(box);
-
+      boxes.push_back(decode(det_output, i, factor).rect);
       confidences.push_back(score);
-
-      std::vector<float> keypoints;
-      cv::Mat kpts = det_output.col(i).rowRange(NUM_POINTS, 15);
-      for (int j = 0; j < NUM_POINTS; ++j) {
-        const float x = kpts.at<float>(j * 2 + 0, 0) * factor;
-        const float y = kpts.at<float>(j * 2 + 1, 0) * factor;
-        keypoints.push_back(x);
-        keypoints.push_back(y);
-      }
-      objects_keypoints.push_back(keypoints);
+      candidates.push_back(i);
     }
   }
 
+  // NMS 输出按置信度从高到低排列
   std::vector<int> indexes;
   cv::dnn::NMSBoxes(boxes, confidences, ConfidenceThreshold, IouThreshold, indexes);
 
-  std::vector<Object> object_result;  
-  for (size_t i = 0; i < indexes.size(); ++i) {
-    Object obj;
-    const int index = indexes[i];
-    obj.rect = boxes[index];
-    obj.prob = confidences[index];
-
-    const std::vector<float> & keypoint = objects_keypoints[index];
-    for (int i = 0; i < NUM_POINTS; ++i) {
-      const float x_coord = keypoint[i * 2];
-      const float y_coord = keypoint[i * 2 + 1];
-      obj.kpt.push_back(cv::Point2f(x_coord, y_coord));
-    }
+  std::vector<Object> object_result;
+  bool hard = false;
+  refiner_.begin_frame();  // 精修点数按帧限制, 置信度高的检测优先
+  for (const int index : indexes) {
+    Object obj = decode(det_output, candidates[index], factor);
+    if (refine_keypoints_) refiner_.refine(image, obj.kpt);
+    hard |= obj.prob < harvest_confidence_;
     object_result.push_back(obj);
-
-    cv::rectangle(image, obj.rect, cv::Scalar(255, 255, 255), 1, 8);           
-    const std::string label = "buff:" + std::to_string(obj.prob).substr(0, 4); 
-    const cv::Size textSize = cv::getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, nullptr);
-    const cv::Rect textBox(
-      obj.rect.tl().x, obj.rect.tl().y - 15, textSize.width, textSize.height + 5);
-    cv::rectangle(image, textBox, cv::Scalar(0, 255, 255), cv::FILLED);
-    cv::putText(
-      image, label, cv::Point(obj.rect.tl().x, obj.rect.tl().y - 5), cv::FONT_HERSHEY_SIMPLEX, 0.5,
-      cv::Scalar(0, 0, 0));
-    const int radius = 2;  
-    const cv::Size & shape = image.size();
-    for (int i = 0; i < NUM_POINTS; ++i)
-      cv::circle(image, obj.kpt[i], radius, cv::Scalar(255, 0, 0), -1, cv::LINE_AA);
   }
 
-  const float t = (cv::getTickCount() - start) / static_cast<float>(cv::getTickFrequency());
-  cv::putText(
-    image, cv::format("FPS: %.2f", 1.0 / t), cv::Point(20, 40), cv::FONT_HERSHEY_PLAIN, 2.0,
-    cv::Scalar(255, 0, 0), 2, 8);
-
-
+  // 同一帧的所有检测一起作为标注, 避免样本中漏标其他扇叶
+  if (harvester_ && hard) {
+    std::vector<tools::HarvestLabel> labels;
+    for (const auto & obj : object_result) labels.push_back({0, obj.rect, obj.kpt});
+    harvester_->submit(image, labels, "low_confidence");
+  }
   return object_result;
 }
 
-std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::get_onecandidatebox(cv::Mat & image)
+std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::get_onecandidatebox(const cv::Mat & image)
 {
-  const int64 start = cv::getTickCount(); 
   const float factor = fill_tensor_data_image(input_tensor, image);  
   infer_request.infer();
   const ov::Tensor output = infer_request.get_output_tensor(); 
@@ -144,49 +161,49 @@ std::vector<YOLO11_BUFF::Object> YOLO11_BUFF::get_onecandidatebox(cv::Mat & imag
   }
   std::vector<Object> object_result;  
   if (max_confidence > ConfidenceThreshold) {
-    Object obj;
-    const float cx = det_output.at<float>(0, best_index);
-    const float cy = det_output.at<float>(1, best_index);
-    const float ow = det_output.at<float>(2, best_index);
-    const float oh = det_output.at<float>(3, best_index);
-    obj.rect.x = static_cast<int>((cx - 0.5 * ow) * factor);
-    obj.rect.y = static_cast<int>((cy - 0.5 * oh) * factor);
-    obj.rect.width = static_cast<int>(ow * factor);
-    obj.rect.height = static_cast<int>(oh * factor);
-    obj.prob = max_confidence;
-    cv::Mat kpts = det_output.col(best_index).rowRange(5, 5 + NUM_POINTS * 2);
-    for (int i = 0; i < NUM_POINTS; ++i) {
-      const float x = kpts.at<float>(i * 2 + 0, 0) * factor;
-      const float y = kpts.at<float>(i * 2 + 1, 0) * factor;
-      obj.kpt.push_back(cv::Point2f(x, y));
-    }
+    Object obj = decode(det_output, best_index, factor);
+    refiner_.begin_frame();
+    if (refine_keypoints_) refiner_.refine(image, obj.kpt);
     object_result.push_back(obj);
-    if (max_confidence < 0.7) save(std::to_string(start), image);
-    cv::rectangle(image, obj.rect, cv::Scalar(255, 255, 255), 1, 8);                 
-    const std::string label = "buff:" + std::to_string(max_confidence).substr(0, 4);  
-    const cv::Size textSize = cv::getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, nullptr);
-    const cv::Rect textBox(
-      obj.rect.tl().x, obj.rect.tl().y - 15, textSize.width, textSize.height + 5);
-    cv::rectangle(image, textBox, cv::Scalar(0, 255, 255), cv::FILLED);
-    cv::putText(
-      image, label, cv::Point(obj.rect.tl().x, obj.rect.tl().y - 5), cv::FONT_HERSHEY_SIMPLEX, 0.5,
-      cv::Scalar(0, 0, 0));
-    const int radius = 2;  
-    const cv::Size & shape = image.size();
-    for (int i = 0; i < NUM_POINTS; ++i) {
-      cv::circle(image, obj.kpt[i], radius, cv::Scalar(255, 255, 0), -1, cv::LINE_AA);
-      cv::putText(
-        image, std::to_string(i + 1), obj.kpt[i] + cv::Point2f(5, -5), cv::FONT_HERSHEY_SIMPLEX,
-        0.5, cv::Scalar(255, 255, 0), 1, cv::LINE_AA);
-    }
+    if (harvester_ && max_confidence < harvest_confidence_)
+      harvester_->submit(image, {{0, obj.rect, obj.kpt}}, "low_confidence");
   }
-  const float t = (cv::getTickCount() - start) / static_cast<float>(cv::getTickFrequency());
-  cv::putText(
-    image, cv::format("FPS: %.2f", 1.0 / t), cv::Point(20, 40), cv::FONT_HERSHEY_PLAIN, 2.0,
-    cv::Scalar(255, 0, 0), 2, 8);
   return object_result;
 }
 
+YOLO11_BUFF::Object YOLO11_BUFF::decode(const cv::Mat & det_output, int index, float factor) const
+{
+  // 每列: cx, cy, w, h, score, 之后是 NUM_POINTS 个关键点的 x, y
+  Object obj;
+  const float cx = det_output.at<float>(0, index);
+  const float cy = det_output.at<float>(1, index);
+  const float ow = det_output.at<float>(2, index);
+  const float oh = det_output.at<float>(3, index);
+  obj.rect.x = static_cast<int>((cx - 0.5 * ow) * factor);
+  obj.rect.y = static_cast<int>((cy - 0.5 * oh) * factor);
+  obj.rect.width = static_cast<int>(ow * factor);
+  obj.rect.height = static_cast<int>(oh * factor);
+  obj.label = 0;
+  obj.prob = det_output.at<float>(4, index);
+  cv::Mat kpts = det_output.col(index).rowRange(5, 5 + NUM_POINTS * 2);
+  for (int i = 0; i < NUM_POINTS; ++i) {
+    const float x = kpts.at<float>(i * 2 + 0, 0) * factor;
+    const float y = kpts.at<float>(i * 2 + 1, 0) * factor;
+    obj.kpt.push_back(cv::Point2f(x, y));
+  }
+  return obj;
+}
+
+void YOLO11_BUFF::warmup(int times)
+{
+  auto begin = std::chrono::steady_clock::now();
+  std::fill_n(input_tensor.data<float>(), input_tensor.get_size(), 0.0f);
+  for (int i = 0; i < times; i++) infer_request.infer();
+  tools::logger()->info(
+    "YOLO11_BUFF warmed up with {} inferences in {:.0f} ms", times,
+    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+}
+
 void YOLO11_BUFF::convert(
   const cv::Mat & input, cv::Mat & output, const bool normalize, const bool BGR2RGB) const
 {
@@ -259,13 +276,10 @@ void YOLO11_BUFF::printInputAndOutputsInfo(const ov::Model & network)
   }
 }
 
-void YOLO11_BUFF::save(const std::string & programName, const cv::Mat & image)
+void YOLO11_BUFF::set_harvester(
+  std::shared_ptr<tools::Harvester> harvester, float harvest_confidence)
 {
-  const std::filesystem::path saveDir = "../result/";
-  if (!std::filesystem::exists(saveDir)) {
-    std::filesystem::create_directories(saveDir);
-  }
-  const std::filesystem::path savePath = saveDir / (programName + ".jpg");
-  cv::imwrite(savePath.string(), image);
+  harvester_ = std::move(harvester);
+  harvest_confidence_ = harvest_confidence;
 }
 }  // namespace auto_buff
\ No newline at end of file
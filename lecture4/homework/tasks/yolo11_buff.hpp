@@ -5,11 +5,25 @@
 #include <opencv2/opencv.hpp>
 #include <openvino/openvino.hpp>
 
+#include "keypoint_refiner.hpp"
+#include "tools/harvester.hpp"
 
 namespace auto_buff
 {
 const std::vector<std::string> class_names = {"buff", "r"};
 
+// 模型变体与推理参数, 默认值即主程序使用的配置
+struct BuffModelConfig
+{
+  std::string model_path = "assets/yolo11_buff_int8.xml";
+  int input_size = 640;   // 正方形输入边长, 与导出尺寸不同时在编译前reshape
+  std::string precision;  // 推理精度提示: "f32", "f16", "bf16", 为空时使用插件默认
+  int streams = 0;        // ov::num_streams, 0为插件默认
+  int threads = 0;        // ov::inference_num_threads, 0时使用线程配置中的 inference.threads
+  // 编译结果缓存目录, 为空时不缓存; OpenVINO按模型哈希、设备与编译参数区分缓存文件
+  std::string cache_dir = "cache/openvino";
+};
+
 class YOLO11_BUFF
 {
 public:
@@ -21,11 +35,26 @@ public:
     std::vector<cv::Point2f> kpt;
   };
 
-  YOLO11_BUFF();
+  // refine_keypoints: 是否在原图上对关键点做亚像素精修
+  explicit YOLO11_BUFF(bool refine_keypoints = false, const BuffModelConfig & config = {});
+
+  // 只输出检测结果, 不在输入图像上绘制, 可视化见 tools::Visualizer
+  // 输出 NMS 后的所有检测, 按置信度从高到低排列
+  std::vector<Object> get_multicandidateboxes(const cv::Mat & image);
+
+  // 与 get_multicandidateboxes 相同, 拆为两步: start 预处理后开始异步推理即返回, wait 等待推理完成并解码
+  // 多个实例(如每台相机一个)先分别 start 再依次 wait, 推理并行进行; image 在 wait 返回前须保持有效
+  void start_multicandidateboxes(const cv::Mat & image);
+  std::vector<Object> wait_multicandidateboxes();
 
-  std::vector<Object> get_multicandidateboxes(cv::Mat & image);
+  std::vector<Object> get_onecandidatebox(const cv::Mat & image);
 
-  std::vector<Object> get_onecandidatebox(cv::Mat & image);
+  // 用空白输入推理若干次, 让插件完成内存分配与内核选择, 使第一帧的耗时与稳态一致
+  void warmup(int times = 3);
+
+  // 置信度低于 harvest_confidence 的检测(已通过检测阈值)交给收集器, 为空时不收集
+  void set_harvester(
+    std::shared_ptr<tools::Harvester> harvester, float harvest_confidence = 0.85f);
 
 private:
   ov::Core core;  
@@ -34,6 +63,18 @@ private:
   ov::InferRequest infer_request;
   ov::Tensor input_tensor;
   const int NUM_POINTS = 6;
+  int input_size_;
+  bool refine_keypoints_;
+  KeypointRefiner refiner_;
+  std::shared_ptr<tools::Harvester> harvester_;
+  float harvest_confidence_;
+
+  // start_multicandidateboxes 的输入, 供 wait_multicandidateboxes 精修关键点与收集样本
+  cv::Mat pending_image_;
+  float pending_factor_ = 1.0f;
+
+  // 解码输出矩阵的第 index 列, factor 为输入尺寸到原图的缩放
+  Object decode(const cv::Mat & det_output, int index, float factor) const;
 
   void convert(
     const cv::Mat & input, cv::Mat & output, const bool normalize, const bool exchangeRB) const;
@@ -41,8 +82,6 @@ private:
   float fill_tensor_data_image(ov::Tensor & input_tensor, const cv::Mat & input_image) const;
 
   void printInputAndOutputsInfo(const ov::Model & network);
-
-  void save(const std::string & programName, const cv::Mat & image);
 };
 }  // namespace auto_buff
 #endif
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "ballistic_table.hpp"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+
+#include "tools/logger.hpp"
+
+namespace
+{
+constexpr uint32_t MAGIC = 0x42414c54;  // "BALT"
+constexpr uint32_t VERSION = 1;
+
+// 积分步长与俯仰角扫描步长, 同时决定建表精度
+constexpr double DT = 1e-4;                    // s
+constexpr double PITCH_STEP = 0.02 / 57.3;     // rad
+constexpr double PITCH_MIN = -60.0 / 57.3;     // rad
+constexpr double PITCH_MAX = 60.0 / 57.3;      // rad
+constexpr double MAX_FLY_TIME = 3.0;           // s
+const float NaN = std::numeric_limits<float>::quiet_NaN();
+}  // namespace
+
+namespace tools
+{
+BallisticTable::BallisticTable(const Params & params, const std::string & cache_dir)
+: params_(params)
+{
+  cols_ = static_cast<int>(std::round((params_.d_max - params_.d_min) / params_.step)) + 1;
+  rows_ = static_cast<int>(std::round((params_.h_max - params_.h_min) / params_.step)) + 1;
+
+  auto path = cache_path(cache_dir);
+  if (load(path)) {
+    logger()->info("Ballistic table loaded from {}", path);
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  build();
+  auto cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  logger()->info("Ballistic table ({}x{}) built in {:.2f}s", rows_, cols_, cost);
+
+  save(path);
+}
+
+std::optional<BallisticTable::Solution> BallisticTable::lookup(double d, double h) const
+{
+  auto u = (d - params_.d_min) / params_.step;
+  auto v = (h - params_.h_min) / params_.step;
+  if (!(u >= 0 && u <= cols_ - 1 && v >= 0 && v <= rows_ - 1)) return std::nullopt;
+
+  auto c = std::min(static_cast<int>(u), cols_ - 2);
+  auto r = std::min(static_cast<int>(v), rows_ - 2);
+  auto fu = u - c;
+  auto fv = v - r;
+
+  auto bilinear = [&](const std::vector<float> & table) {
+    auto i = r * cols_ + c;
+    return (table[i] * (1 - fu) + table[i + 1] * fu) * (1 - fv) +
+           (table[i + cols_] * (1 - fu) + table[i + cols_ + 1] * fu) * fv;
+  };
+
+  auto pitch = bilinear(pitch_);
+  if (std::isnan(pitch)) return std::nullopt;
+
+  return Solution{pitch, bilinear(fly_time_)};
+}
+
+// 对每个俯仰角只积分一次弹道, 记录弹丸经过每个网格距离时的高度与时间;
+// 再逐列把 高度(俯仰角) 反解为 俯仰角(高度), 只取上升段(直射)的单调分支
+void BallisticTable::build()
+{
+  auto n_pitch = static_cast<int>((PITCH_MAX - PITCH_MIN) / PITCH_STEP) + 1;
+  std::vector<float> heights(n_pitch * cols_, NaN), times(n_pitch * cols_, NaN);
+
+  for (int p = 0; p < n_pitch; p++) {
+    auto pitch = PITCH_MIN + p * PITCH_STEP;
+    double x = 0, y = 0, t = 0;
+    double vx = params_.v0 * std::cos(pitch), vy = params_.v0 * std::sin(pitch);
+
+    int c = 0;
+    while (c < cols_ && t < MAX_FLY_TIME && vx > 0) {
+      auto v = std::sqrt(vx * vx + vy * vy);
+      auto ax = -params_.k * v * vx;
+      auto ay = -params_.k * v * vy - params_.g;
+      auto nx = x + vx * DT, ny = y + vy * DT;
+
+      while (c < cols_ && params_.d_min + c * params_.step <= nx) {
+        auto ratio = (params_.d_min + c * params_.step - x) / (nx - x);
+        heights[p * cols_ + c] = y + (ny - y) * ratio;
+        times[p * cols_ + c] = t + DT * ratio;
+        c++;
+      }
+
+      x = nx, y = ny, t += DT;
+      vx += ax * DT, vy += ay * DT;
+    }
+  }
+
+  pitch_.assign(rows_ * cols_, NaN);
+  fly_time_.assign(rows_ * cols_, NaN);
+
+  for (int c = 0; c < cols_; c++) {
+    for (int p = 0; p + 1 < n_pitch; p++) {
+      auto h0 = heights[p * cols_ + c], h1 = heights[(p + 1) * cols_ + c];
+      if (std::isnan(h0) || std::isnan(h1)) continue;  // 该俯仰角在时限内飞不到这个距离
+      if (h1 <= h0) break;                              // 越过最高点, 后面是吊射分支
+
+      auto r_begin = std::max(0, static_cast<int>(std::ceil((h0 - params_.h_min) / params_.step)));
+      auto r_end = std::min(rows_ - 1, static_cast<int>(std::floor((h1 - params_.h_min) / params_.step)));
+      for (int r = r_begin; r <= r_end; r++) {
+        auto h = params_.h_min + r * params_.step;
+        auto ratio = (h - h0) / (h1 - h0);
+        pitch_[r * cols_ + c] = PITCH_MIN + (p + ratio) * PITCH_STEP;
+        fly_time_[r * cols_ + c] =
+          times[p * cols_ + c] + (times[(p + 1) * cols_ + c] - times[p * cols_ + c]) * ratio;
+      }
+    }
+  }
+}
+
+bool BallisticTable::load(const std::string & path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+
+  uint32_t magic, version;
+  Params params;
+  file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  file.read(reinterpret_cast<char *>(&version), sizeof(version));
+  file.read(reinterpret_cast<char *>(&params), sizeof(params));
+  if (!file || magic != MAGIC || version != VERSION) return false;
+  if (std::memcmp(&params, &params_, sizeof(Params)) != 0) return false;
+
+  pitch_.resize(rows_ * cols_);
+  fly_time_.resize(rows_ * cols_);
+  file.read(reinterpret_cast<char *>(pitch_.data()), pitch_.size() * sizeof(float));
+  file.read(reinterpret_cast<char *>(fly_time_.data()), fly_time_.size() * sizeof(float));
+  return static_cast<bool>(file);
+}
+
+void BallisticTable::save(const std::string & path) const
+{
+  std::error_code ec;
+  std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    logger()->warn("Unable to write ballistic table cache: {}", path);
+    return;
+  }
+
+  file.write(reinterpret_cast<const char *>(&MAGIC), sizeof(MAGIC));
+  file.write(reinterpret_cast<const char *>(&VERSION), sizeof(VERSION));
+  file.write(reinterpret_cast<const char *>(&params_), sizeof(params_));
+  file.write(reinterpret_cast<const char *>(pitch_.data()), pitch_.size() * sizeof(float));
+  file.write(reinterpret_cast<const char *>(fly_time_.data()), fly_time_.size() * sizeof(float));
+}
+
+// 缓存文件名由参数哈希得到, 参数变化后自动重建
+std::string BallisticTable::cache_path(const std::string & cache_dir) const
+{
+  std::string bytes(reinterpret_cast<const char *>(&params_), sizeof(params_));
+  auto hash = std::hash<std::string>{}(bytes) ^ VERSION;
+  return fmt::format("{}/ballistic_{:016x}.bin", cache_dir, hash);
+}
+
+}  // namespace tools
@@ -0,0 +1,55 @@
+#ifndef TOOLS__BALLISTIC_TABLE_HPP
+#define TOOLS__BALLISTIC_TABLE_HPP
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tools
+{
+struct BallisticParams
+{
+  double v0 = 25.0;      // 弹速, 单位: m/s
+  double k = 0.0019;     // 空气阻力系数, a = -k * |v| * v, 单位: 1/m
+  double g = 9.794;      // 重力加速度, 单位: m/s^2
+  double d_min = 0.5;    // 水平距离范围, 单位: m
+  double d_max = 15.0;
+  double h_min = -2.0;   // 高度差范围(向上为正), 单位: m
+  double h_max = 3.0;
+  double step = 0.05;    // 网格间距, 单位: m
+};
+
+// 带空气阻力的弹道查找表: (水平距离, 高度差) -> (出射俯仰角, 飞行时间)
+// 启动时建表并缓存到磁盘, 查表为常数时间的双线性插值
+class BallisticTable
+{
+public:
+  using Params = BallisticParams;
+
+  struct Solution
+  {
+    double pitch;     // 向上为正, 单位: rad
+    double fly_time;  // 单位: s
+  };
+
+  explicit BallisticTable(const Params & params = Params(), const std::string & cache_dir = "cache");
+
+  // 超出表范围或打不到时返回 std::nullopt
+  std::optional<Solution> lookup(double d, double h) const;
+
+  const Params & params() const { return params_; }
+
+private:
+  Params params_;
+  int rows_, cols_;  // rows_: 高度, cols_: 距离
+  std::vector<float> pitch_, fly_time_;  // 打不到的格子记为NaN
+
+  void build();
+  bool load(const std::string & path);
+  void save(const std::string & path) const;
+  std::string cache_path(const std::string & cache_dir) const;
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__BALLISTIC_TABLE_HPP
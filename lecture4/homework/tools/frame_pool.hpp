@@ -0,0 +1,43 @@
+#ifndef TOOLS__FRAME_POOL_HPP
+#define TOOLS__FRAME_POOL_HPP
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace tools
+{
+// 图像缓冲池: 采集线程循环复用预先分配的图像, 避免每帧申请/释放数MB内存
+// 缓冲区在下游不再引用(引用计数只剩池本身)后才会被复用; 只允许单个线程调用 acquire
+class FramePool
+{
+public:
+  explicit FramePool(size_t size = 8) : slots_(size), next_(0), misses_(0) {}
+
+  // 返回一块 rows x cols 的图像, 池中缓冲区都被下游占用时临时分配
+  cv::Mat acquire(int rows, int cols, int type)
+  {
+    for (size_t i = 0; i < slots_.size(); i++) {
+      auto & slot = slots_[(next_ + i) % slots_.size()];
+      if (!slot.empty() && slot.u && slot.u->refcount > 1) continue;
+
+      next_ = (next_ + i + 1) % slots_.size();
+      slot.create(rows, cols, type);
+      return slot;
+    }
+
+    misses_++;
+    return cv::Mat(rows, cols, type);
+  }
+
+  // 池中没有空闲缓冲区的次数, 持续增长说明下游持有的帧多于池的大小
+  size_t misses() const { return misses_; }
+
+private:
+  std::vector<cv::Mat> slots_;
+  size_t next_;
+  size_t misses_;
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__FRAME_POOL_HPP
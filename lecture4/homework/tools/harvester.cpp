@@ -0,0 +1,164 @@
+#include "harvester.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include "logger.hpp"
+#include "thread_config.hpp"
+
+namespace tools
+{
+Harvester::Harvester(const std::string & dir, const HarvesterConfig & config)
+: dir_(dir),
+  config_(config),
+  period_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::duration<double>(1.0 / std::max(config.max_rate_hz, 1e-3)))),
+  next_accept_(std::chrono::steady_clock::now()),
+  quit_(false),
+  bytes_(0),
+  saved_(0),
+  dropped_(0)
+{
+  for (auto sub : {"images", "labels", "crops"}) std::filesystem::create_directories(dir_ / sub);
+
+  // 配额按整个目录计算, 包括之前几次运行收集的样本
+  uint64_t bytes = 0;
+  for (const auto & entry : std::filesystem::recursive_directory_iterator(dir_))
+    if (entry.is_regular_file()) bytes += entry.file_size();
+  bytes_ = bytes;
+  tools::logger()->info(
+    "Harvester writing to {} ({} MB used, quota {} MB).", dir_.string(), bytes >> 20,
+    config_.quota_mb);
+
+  writer_thread_ = std::thread{[this] { write_loop(); }};
+}
+
+Harvester::~Harvester()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    quit_ = true;
+  }
+  condition_.notify_one();
+  if (writer_thread_.joinable()) writer_thread_.join();
+  tools::logger()->info("Harvester stopped, {} samples saved, {} dropped.", saved_, dropped_);
+}
+
+bool Harvester::submit(
+  const cv::Mat & img, const std::vector<HarvestLabel> & labels, const std::string & reason)
+{
+  if (img.empty()) return false;
+  if (bytes_ >= (uint64_t(config_.quota_mb) << 20)) {
+    dropped_++;
+    return false;
+  }
+
+  // 先粗筛一次, 大部分被限频的样本不必拷贝图像
+  auto accepting = [this](std::chrono::steady_clock::time_point now) {
+    return now >= next_accept_ && queue_.size() < config_.queue_size;
+  };
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!accepting(std::chrono::steady_clock::now())) {
+      dropped_++;
+      return false;
+    }
+  }
+
+  // 拷贝在锁外进行; 相机的缓冲池会复用原图
+  auto stamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::system_clock::now().time_since_epoch())
+                 .count();
+  Sample sample{img.clone(), labels, fmt::format("{}_{}", stamp, reason)};
+
+  // 检查与入队在同一把锁内, 多个线程同时提交时不会都通过限频
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto now = std::chrono::steady_clock::now();
+  if (!accepting(now)) {
+    dropped_++;
+    return false;
+  }
+  next_accept_ = now + period_;
+  queue_.push_back(std::move(sample));
+  condition_.notify_one();
+  return true;
+}
+
+void Harvester::write_loop()
+{
+  tools::apply_thread_policy("harvester");
+
+  while (true) {
+    Sample sample;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this] { return quit_ || !queue_.empty(); });
+      if (queue_.empty()) break;  // 退出前写完已接收的样本
+      sample = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    write(sample);
+  }
+}
+
+void Harvester::write(const Sample & sample)
+{
+  std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, config_.jpeg_quality};
+  std::vector<uint8_t> jpeg;
+
+  // 完整图像与 YOLO 格式标注: 类别 cx cy w h [x y]..., 均按图像宽高归一化
+  if (!cv::imencode(".jpg", sample.img, jpeg, params)) {
+    tools::logger()->warn("Harvester failed to encode {}", sample.name);
+    return;
+  }
+  auto bytes = write_file(dir_ / "images" / (sample.name + ".jpg"), jpeg);
+
+  auto w = static_cast<float>(sample.img.cols), h = static_cast<float>(sample.img.rows);
+  std::string text;
+  for (const auto & label : sample.labels) {
+    const auto & box = label.box;
+    text += fmt::format(
+      "{} {:.6f} {:.6f} {:.6f} {:.6f}", label.class_id, (box.x + box.width / 2) / w,
+      (box.y + box.height / 2) / h, box.width / w, box.height / h);
+    for (const auto & point : label.keypoints)
+      text += fmt::format(" {:.6f} {:.6f}", point.x / w, point.y / h);
+    text += '\n';
+  }
+  bytes += write_file(
+    dir_ / "labels" / (sample.name + ".txt"), std::vector<uint8_t>(text.begin(), text.end()));
+
+  // 目标附近的裁剪图, 便于快速浏览与人工复核
+  if (config_.crop_margin > 0) {
+    for (size_t i = 0; i < sample.labels.size(); i++) {
+      const auto & box = sample.labels[i].box;
+      auto dx = box.width * config_.crop_margin, dy = box.height * config_.crop_margin;
+      cv::Rect crop(
+        cv::Point(box.x - dx, box.y - dy),
+        cv::Point(box.x + box.width + dx, box.y + box.height + dy));
+      crop &= cv::Rect(0, 0, sample.img.cols, sample.img.rows);
+      if (crop.empty() || !cv::imencode(".jpg", sample.img(crop), jpeg, params)) continue;
+      bytes += write_file(dir_ / "crops" / fmt::format("{}_{}.jpg", sample.name, i), jpeg);
+    }
+  }
+
+  bytes_ += bytes;
+  saved_++;
+  if (bytes_ >= (uint64_t(config_.quota_mb) << 20))
+    tools::logger()->warn("Harvester reached its {} MB quota, stop collecting.", config_.quota_mb);
+}
+
+uint64_t Harvester::write_file(
+  const std::filesystem::path & path, const std::vector<uint8_t> & data)
+{
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char *>(data.data()), data.size());
+  if (!file) {
+    tools::logger()->warn("Harvester failed to write {}", path.string());
+    return 0;
+  }
+  return data.size();
+}
+
+}  // namespace tools
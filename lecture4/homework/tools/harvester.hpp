@@ -0,0 +1,82 @@
+#ifndef TOOLS__HARVESTER_HPP
+#define TOOLS__HARVESTER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tools
+{
+// 一个目标的标注, 图像坐标
+struct HarvestLabel
+{
+  int class_id = 0;
+  cv::Rect2f box;
+  std::vector<cv::Point2f> keypoints;
+};
+
+struct HarvesterConfig
+{
+  size_t queue_size = 8;     // 写盘来不及时最多积压的样本数, 超出的直接丢弃
+  double max_rate_hz = 2;    // 每秒最多收集的样本数, 比赛中同一困难场景会连续出现很多帧
+  size_t quota_mb = 4096;    // 目录总大小上限, 达到后停止收集
+  int jpeg_quality = 95;
+  double crop_margin = 0.5;  // 裁剪图在目标框四周各扩展框大小的比例, 0 表示不保存裁剪图
+};
+
+// 困难样本收集器: 检测线程通过 submit 提交低置信度或前后不一致的检测结果
+// 编码与写盘在后台线程上进行, 队列满、超出频率或配额时丢弃, submit 从不阻塞
+// 目录结构与 YOLO 数据集一致: images/名称.jpg, labels/名称.txt, 另有 crops/ 保存目标附近的裁剪图
+class Harvester
+{
+public:
+  explicit Harvester(const std::string & dir, const HarvesterConfig & config = {});
+  ~Harvester();
+
+  // reason 用于文件名, 便于按来源筛选; img 只在被接收时拷贝
+  // 返回是否被接收
+  bool submit(
+    const cv::Mat & img, const std::vector<HarvestLabel> & labels, const std::string & reason);
+
+  uint64_t saved() const { return saved_; }
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  struct Sample
+  {
+    cv::Mat img;
+    std::vector<HarvestLabel> labels;
+    std::string name;
+  };
+
+  const std::filesystem::path dir_;
+  const HarvesterConfig config_;
+  const std::chrono::steady_clock::duration period_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Sample> queue_;
+  std::chrono::steady_clock::time_point next_accept_;
+  bool quit_;
+
+  std::atomic<uint64_t> bytes_;  // 目录当前大小
+  std::atomic<uint64_t> saved_;
+  std::atomic<uint64_t> dropped_;
+  std::thread writer_thread_;
+
+  void write_loop();
+  void write(const Sample & sample);
+  uint64_t write_file(const std::filesystem::path & path, const std::vector<uint8_t> & data);
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__HARVESTER_HPP
@@ -1,6 +1,7 @@
 #include "logger.hpp"
 
 #include <fmt/chrono.h>
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
@@ -12,7 +13,7 @@ namespace tools
 {
 std::shared_ptr<spdlog::logger> logger_ = nullptr;
 
-void set_logger()
+std::vector<spdlog::sink_ptr> make_sinks()
 {
   auto file_name = fmt::format("logs/{:%Y-%m-%d_%H-%M-%S}.log", std::chrono::system_clock::now());
   auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(file_name, true);
@@ -21,11 +22,36 @@ void set_logger()
   auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
   console_sink->set_level(spdlog::level::debug);
 
-  logger_ = std::make_shared<spdlog::logger>("", spdlog::sinks_init_list{file_sink, console_sink});
+  return {file_sink, console_sink};
+}
+
+void set_logger()
+{
+  auto sinks = make_sinks();
+  logger_ = std::make_shared<spdlog::logger>("", sinks.begin(), sinks.end());
   logger_->set_level(spdlog::level::debug);
   logger_->flush_on(spdlog::level::info);
 }
 
+void set_async_logger(size_t queue_size)
+{
+  // 队列在此一次性分配, 写线程只有一个以保证日志顺序
+  spdlog::init_thread_pool(queue_size, 1);
+
+  auto sinks = make_sinks();
+  logger_ = std::make_shared<spdlog::async_logger>(
+    "", sinks.begin(), sinks.end(), spdlog::thread_pool(),
+    spdlog::async_overflow_policy::overrun_oldest);
+  logger_->set_level(spdlog::level::debug);
+  logger_->flush_on(spdlog::level::info);  // flush 也在写线程上执行
+}
+
+size_t dropped_logs()
+{
+  auto pool = spdlog::thread_pool();
+  return pool ? pool->overrun_counter() : 0;
+}
+
 std::shared_ptr<spdlog::logger> logger()
 {
   if (!logger_) set_logger();
@@ -0,0 +1,303 @@
+#ifndef TOOLS__PIPELINE_HPP
+#define TOOLS__PIPELINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "tools/logger.hpp"
+
+namespace tools
+{
+// 队列满时的处理方式
+// block: 上游等待; drop_oldest: 丢弃队首(保留最新数据); drop_newest: 丢弃新数据
+enum class Backpressure
+{
+  block,
+  drop_oldest,
+  drop_newest
+};
+
+template <typename T>
+class Channel
+{
+public:
+  Channel(size_t capacity, Backpressure policy)
+  : capacity_(std::max<size_t>(1, capacity)), policy_(policy), closed_(false), dropped_(0)
+  {
+  }
+
+  // 关闭后或按策略丢弃时返回false
+  bool push(T && value)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (policy_ == Backpressure::block)
+      not_full_.wait(lock, [this] { return closed_ || queue_.size() < capacity_; });
+    if (closed_) return false;
+
+    if (queue_.size() >= capacity_) {
+      dropped_++;
+      if (policy_ == Backpressure::drop_newest) return false;
+      queue_.pop_front();
+    }
+
+    queue_.emplace_back(std::move(value));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // 队列已关闭且为空时返回false
+  bool pop(T & value)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+    if (queue_.empty()) return false;
+
+    value = std::move(queue_.front());
+    queue_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  // 上游结束: 下游取完剩余数据后退出
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  const size_t capacity_;
+  const Backpressure policy_;
+  std::deque<T> queue_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_, not_full_;
+  bool closed_;
+  std::atomic<uint64_t> dropped_;
+};
+
+// 阶段的输出端口, 只能被下游消费一次
+template <typename T>
+struct Port
+{
+  std::shared_ptr<Channel<T>> channel;
+};
+
+// 把多个函数融合为一个阶段, 在同一线程上依次执行, 省去中间队列
+template <typename F>
+auto fuse(F && f)
+{
+  return std::forward<F>(f);
+}
+
+template <typename F, typename G, typename... Rest>
+auto fuse(F && f, G && g, Rest &&... rest)
+{
+  return fuse(
+    [f = std::forward<F>(f), g = std::forward<G>(g)](auto && x) mutable {
+      return g(f(std::forward<decltype(x)>(x)));
+    },
+    std::forward<Rest>(rest)...);
+}
+
+// 流水线: 每个阶段独占一个线程, 阶段之间以有界队列连接
+// 阶段类型在编译期由函数签名推导: 源 () -> std::optional<T>, 中间 In -> Out, 汇 In -> void
+class Pipeline
+{
+public:
+  struct StageStats
+  {
+    std::string name;
+    bool source = false;  // 源阶段的耗时包括 f() 内等待数据(如等相机出图)的时间
+    std::atomic<uint64_t> count{0};
+    std::atomic<int64_t> busy_ns{0};
+    std::atomic<int64_t> max_ns{0};
+    std::function<uint64_t()> dropped = [] { return 0; };
+
+    void record(std::chrono::steady_clock::duration elapsed)
+    {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+      count.fetch_add(1, std::memory_order_relaxed);
+      busy_ns.fetch_add(ns, std::memory_order_relaxed);
+      if (ns > max_ns.load(std::memory_order_relaxed)) max_ns.store(ns, std::memory_order_relaxed);
+    }
+  };
+
+  Pipeline() : stop_(false) {}
+
+  ~Pipeline()
+  {
+    stop();
+    for (auto & thread : threads_)
+      if (thread.joinable()) thread.join();
+  }
+
+  // 源阶段: f 返回 std::nullopt 表示数据结束
+  template <typename F>
+  auto source(
+    const std::string & name, F f, size_t capacity = 1,
+    Backpressure policy = Backpressure::drop_oldest)
+  {
+    using Out = typename std::invoke_result_t<F &>::value_type;
+    auto out = make_channel<Out>(capacity, policy);
+    auto stats = make_stats(name, out);
+    stats->source = true;
+
+    tasks_.push_back({name, [this, f = std::move(f), out, stats]() mutable {
+      while (!stop_) {
+        auto begin = std::chrono::steady_clock::now();
+        auto value = f();
+        stats->record(std::chrono::steady_clock::now() - begin);
+        if (!value) break;
+        out->push(std::move(*value));
+      }
+      out->close();
+    }});
+    return Port<Out>{out};
+  }
+
+  // 中间阶段: In -> Out
+  template <typename In, typename F>
+  auto stage(
+    const std::string & name, Port<In> in, F f, size_t capacity = 2,
+    Backpressure policy = Backpressure::block)
+  {
+    using Out = std::invoke_result_t<F &, In &&>;
+    auto out = make_channel<Out>(capacity, policy);
+    auto stats = make_stats(name, out);
+
+    tasks_.push_back({name, [f = std::move(f), in = in.channel, out, stats]() mutable {
+      In value;
+      while (in->pop(value)) {
+        auto begin = std::chrono::steady_clock::now();
+        auto result = f(std::move(value));
+        stats->record(std::chrono::steady_clock::now() - begin);
+        out->push(std::move(result));
+      }
+      out->close();
+    }});
+    return Port<Out>{out};
+  }
+
+  // 汇阶段: In -> void
+  template <typename In, typename F>
+  void sink(const std::string & name, Port<In> in, F f)
+  {
+    auto stats = make_stats<In>(name, nullptr);
+
+    tasks_.push_back({name, [f = std::move(f), in = in.channel, stats]() mutable {
+      In value;
+      while (in->pop(value)) {
+        auto begin = std::chrono::steady_clock::now();
+        f(std::move(value));
+        stats->record(std::chrono::steady_clock::now() - begin);
+      }
+    }});
+  }
+
+  // 每个阶段线程启动时以阶段名调用, 用于绑核、设置优先级等, 需在 run 之前设置
+  void on_thread_start(std::function<void(const std::string &)> hook)
+  {
+    thread_hook_ = std::move(hook);
+  }
+
+  // 启动所有阶段并等待其结束(源结束或调用stop)
+  void run()
+  {
+    begin_ = std::chrono::steady_clock::now();
+    for (auto & task : tasks_)
+      threads_.emplace_back([this, task = std::move(task)] {
+        if (thread_hook_) thread_hook_(task.name);
+        task.body();
+      });
+    tasks_.clear();
+    for (auto & thread : threads_) thread.join();
+    threads_.clear();
+    end_ = std::chrono::steady_clock::now();
+  }
+
+  // 可在任意线程(包括阶段内部)调用, 关闭所有队列, 阻塞在队列上的阶段随即退出
+  // 无法打断阻塞在 f() 内部的源阶段: 源应使用有时限的等待, 超时后检查 stopping()
+  void stop()
+  {
+    stop_ = true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto & close : closers_) close();
+  }
+
+  // 源阶段内部等待数据时据此及时退出
+  bool stopping() const { return stop_; }
+
+  // 各阶段耗时统计; overlap 为非源阶段忙碌时间之和与墙上时间之比, 大于1说明阶段之间并行
+  // 源阶段的耗时包括等待数据的时间, 相机为瓶颈时接近墙上时间, 因此不计入 overlap
+  void report() const
+  {
+    auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_ - begin_).count();
+    int64_t busy_ns = 0;
+    for (const auto & stats : stats_) {
+      auto count = std::max<uint64_t>(1, stats->count);
+      if (!stats->source) busy_ns += stats->busy_ns;
+      tools::logger()->info(
+        "[{}] {} runs, mean {:.2f} ms{}, max {:.2f} ms, {} dropped", stats->name,
+        stats->count.load(), stats->busy_ns / 1e6 / count, stats->source ? " (incl. waiting)" : "",
+        stats->max_ns / 1e6, stats->dropped());
+    }
+    if (wall_ns > 0)
+      tools::logger()->info(
+        "Pipeline ran {:.2f} s, stage overlap {:.2f}", wall_ns / 1e9, double(busy_ns) / wall_ns);
+  }
+
+private:
+  struct Task
+  {
+    std::string name;
+    std::function<void()> body;
+  };
+
+  std::vector<Task> tasks_;
+  std::function<void(const std::string &)> thread_hook_;
+  std::vector<std::thread> threads_;
+  std::vector<std::shared_ptr<StageStats>> stats_;
+  std::vector<std::function<void()>> closers_;
+  std::mutex mutex_;
+  std::atomic<bool> stop_;
+  std::chrono::steady_clock::time_point begin_, end_;
+
+  template <typename T>
+  std::shared_ptr<Channel<T>> make_channel(size_t capacity, Backpressure policy)
+  {
+    auto channel = std::make_shared<Channel<T>>(capacity, policy);
+    std::lock_guard<std::mutex> lock(mutex_);
+    closers_.emplace_back([channel] { channel->close(); });
+    return channel;
+  }
+
+  template <typename T>
+  std::shared_ptr<StageStats> make_stats(
+    const std::string & name, const std::shared_ptr<Channel<T>> & out)
+  {
+    auto stats = std::make_shared<StageStats>();
+    stats->name = name;
+    if (out) stats->dropped = [out] { return out->dropped(); };
+    stats_.emplace_back(stats);
+    return stats;
+  }
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__PIPELINE_HPP
@@ -1,21 +1,71 @@
 #include "plotter.hpp"
 
 #include <arpa/inet.h>   // htons, inet_addr
-#include <sys/socket.h>  // socket, sendto
+#include <fmt/format.h>
+#include <sys/socket.h>  // socket, sendto, sendmmsg
 #include <unistd.h>      // close
 
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "thread_config.hpp"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+constexpr uint16_t COMMIT_ID = 0xffff;    // ring中标记一帧结束, value为时间戳
+constexpr size_t MAX_DATAGRAM = 1400;     // 小于以太网MTU, 避免IP分片
+constexpr uint32_t MAGIC = 0x31544c50;    // "PLT1"
+constexpr uint8_t SCHEMA = 0, FRAMES = 1;
+
+std::atomic<uint64_t> instance_count{0};
+
+// 每个线程按实例ID缓存自己在各个Plotter实例上的缓冲区, 快速路径只比较一次最近使用的ID
+// 实例ID不会复用, 已析构实例留下的条目不会再被访问
+struct LocalRings
+{
+  uint64_t last_id = 0;
+  void * last_ring = nullptr;
+  std::unordered_map<uint64_t, void *> rings;
+};
+thread_local LocalRings local;
+
+template <typename T>
+void append(std::string & buffer, const T & value)
+{
+  buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+}  // namespace
+
 namespace tools
 {
-Plotter::Plotter(std::string host, uint16_t port)
+Plotter::Plotter(std::string host, uint16_t port, Mode mode)
+: mode_(mode),
+  instance_id_(++instance_count),
+  start_(std::chrono::steady_clock::now()),
+  dropped_(0),
+  quit_(false)
 {
   socket_ = ::socket(AF_INET, SOCK_DGRAM, 0);
 
   destination_.sin_family = AF_INET;
   destination_.sin_port = ::htons(port);
   destination_.sin_addr.s_addr = ::inet_addr(host.c_str());
+
+  sender_thread_ = std::thread{[this] {
+    apply_thread_policy("plotter");
+    send_loop();
+  }};
 }
 
-Plotter::~Plotter() { ::close(socket_); }
+Plotter::~Plotter()
+{
+  quit_ = true;
+  if (sender_thread_.joinable()) sender_thread_.join();
+  ::close(socket_);
+}
 
 void Plotter::plot(const nlohmann::json & json)
 {
@@ -26,4 +76,196 @@ void Plotter::plot(const nlohmann::json & json)
     sizeof(destination_));
 }
 
-}  // namespace tools
\ No newline at end of file
+uint16_t Plotter::field(const std::string & name)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  for (size_t i = 0; i < field_names_.size(); i++)
+    if (field_names_[i] == name) return i;
+
+  field_names_.emplace_back(name);
+  return field_names_.size() - 1;
+}
+
+void Plotter::record(uint16_t id, double value) { push(id, value); }
+
+void Plotter::commit()
+{
+  push(COMMIT_ID, std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count());
+}
+
+Plotter::Ring * Plotter::local_ring()
+{
+  if (local.last_id == instance_id_) return static_cast<Ring *>(local.last_ring);
+
+  // 在多个实例间切换时查表, 每个线程在每个实例上只创建一个缓冲区
+  auto & ring = local.rings[instance_id_];
+  if (!ring) {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    rings_.emplace_back(std::make_unique<Ring>());
+    ring = rings_.back().get();
+  }
+  local.last_id = instance_id_;
+  local.last_ring = ring;
+  return static_cast<Ring *>(ring);
+}
+
+void Plotter::push(uint16_t id, double value)
+{
+  auto ring = local_ring();
+  auto head = ring->head.load(std::memory_order_relaxed);
+  auto tail = ring->tail.load(std::memory_order_acquire);
+
+  if (head - tail >= Ring::CAPACITY) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  ring->samples[head & (Ring::CAPACITY - 1)] = {id, value};
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Plotter::send_loop()
+{
+  std::vector<Ring *> rings;
+  std::vector<std::string> names;
+  std::vector<std::string> keys;  // JSON模式下转义并加引号的字段名
+  std::vector<std::string> datagrams;
+  auto last_schema = std::chrono::steady_clock::time_point();
+
+  while (true) {
+    auto quit = quit_.load();
+
+    {
+      std::lock_guard<std::mutex> lock(registry_mutex_);
+      rings.clear();
+      for (auto & ring : rings_) rings.emplace_back(ring.get());
+      if (names.size() != field_names_.size()) {
+        names = field_names_;
+        last_schema = {};
+      }
+    }
+
+    while (keys.size() < names.size()) {
+      nlohmann::json key = names[keys.size()];
+      keys.emplace_back(key.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+    }
+
+    datagrams.clear();
+
+    // 二进制模式下, 字段表变化时立即下发, 之后每秒重发一次供中途接入的接收端使用
+    auto now = std::chrono::steady_clock::now();
+    if (mode_ == Mode::binary && !names.empty() && now - last_schema > 1s) {
+      serialize_schema(names, datagrams);
+      last_schema = now;
+    }
+
+    for (auto ring : rings) {
+      auto tail = ring->tail.load(std::memory_order_relaxed);
+      auto head = ring->head.load(std::memory_order_acquire);
+
+      for (; tail != head; tail++) {
+        const auto & sample = ring->samples[tail & (Ring::CAPACITY - 1)];
+        if (sample.id != COMMIT_ID) {
+          ring->pending.emplace_back(sample);
+          continue;
+        }
+        serialize_frame(sample, ring->pending, mode_ == Mode::json ? keys : names, datagrams);
+        ring->pending.clear();
+      }
+
+      ring->tail.store(tail, std::memory_order_release);
+    }
+
+    send_batch(datagrams);
+
+    if (quit) break;
+    std::this_thread::sleep_for(5ms);
+  }
+}
+
+// json模式下 names 为已转义并加引号的字段名
+// binary报文: magic(u32) type(u8) 之后若干帧, 每帧为 timestamp(f64) n(u16) n*(id(u16) value(f64))
+void Plotter::serialize_frame(
+  const Sample & commit, const std::vector<Sample> & samples,
+  const std::vector<std::string> & names, std::vector<std::string> & datagrams) const
+{
+  if (mode_ == Mode::json) {
+    fmt::memory_buffer buffer;
+    fmt::format_to(std::back_inserter(buffer), "{{\"timestamp\":{}", commit.value);
+    for (const auto & sample : samples) {
+      if (sample.id >= names.size()) continue;
+      if (std::isfinite(sample.value))
+        fmt::format_to(std::back_inserter(buffer), ",{}:{}", names[sample.id], sample.value);
+      else
+        fmt::format_to(std::back_inserter(buffer), ",{}:null", names[sample.id]);
+    }
+    buffer.push_back('}');
+    datagrams.emplace_back(buffer.data(), buffer.size());
+    return;
+  }
+
+  auto frame_size = sizeof(double) + sizeof(uint16_t) + samples.size() * (sizeof(uint16_t) + sizeof(double));
+  auto header_size = sizeof(MAGIC) + sizeof(FRAMES);
+  if (
+    datagrams.empty() || datagrams.back()[sizeof(MAGIC)] != FRAMES ||
+    datagrams.back().size() + frame_size > MAX_DATAGRAM) {
+    datagrams.emplace_back();
+    datagrams.back().reserve(std::max(MAX_DATAGRAM, header_size + frame_size));
+    append(datagrams.back(), MAGIC);
+    append(datagrams.back(), FRAMES);
+  }
+
+  auto & datagram = datagrams.back();
+  append(datagram, commit.value);
+  append(datagram, static_cast<uint16_t>(samples.size()));
+  for (const auto & sample : samples) {
+    append(datagram, sample.id);
+    append(datagram, sample.value);
+  }
+}
+
+// schema报文: magic(u32) type(u8) n(u16) n*(id(u16) len(u8) name)
+void Plotter::serialize_schema(
+  const std::vector<std::string> & names, std::vector<std::string> & datagrams) const
+{
+  std::string datagram;
+  append(datagram, MAGIC);
+  append(datagram, SCHEMA);
+  append(datagram, static_cast<uint16_t>(names.size()));
+  for (size_t i = 0; i < names.size(); i++) {
+    auto length = static_cast<uint8_t>(std::min<size_t>(names[i].size(), 255));
+    append(datagram, static_cast<uint16_t>(i));
+    append(datagram, length);
+    datagram.append(names[i], 0, length);
+  }
+  datagrams.emplace_back(std::move(datagram));
+}
+
+// 一次系统调用发出一批报文
+void Plotter::send_batch(const std::vector<std::string> & datagrams)
+{
+  if (datagrams.empty()) return;
+
+  std::vector<iovec> iovecs(datagrams.size());
+  std::vector<mmsghdr> messages(datagrams.size());
+  for (size_t i = 0; i < datagrams.size(); i++) {
+    iovecs[i].iov_base = const_cast<char *>(datagrams[i].data());
+    iovecs[i].iov_len = datagrams[i].size();
+
+    std::memset(&messages[i], 0, sizeof(mmsghdr));
+    messages[i].msg_hdr.msg_name = &destination_;
+    messages[i].msg_hdr.msg_namelen = sizeof(destination_);
+    messages[i].msg_hdr.msg_iov = &iovecs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t sent = 0;
+  while (sent < messages.size()) {
+    auto ret = ::sendmmsg(socket_, messages.data() + sent, messages.size() - sent, 0);
+    if (ret <= 0) break;
+    sent += ret;
+  }
+}
+
+}  // namespace tools
@@ -3,27 +3,90 @@
 
 #include <netinet/in.h>  // sockaddr_in
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace tools
 {
 class Plotter
 {
 public:
-  Plotter(std::string host = "127.0.0.1", uint16_t port = 9870);
+  // json: 每帧一个JSON报文, 兼容PlotJuggler的UDP+JSON
+  // binary: 多帧打包进一个报文, 字段名以schema报文单独下发
+  enum class Mode
+  {
+    json,
+    binary
+  };
+
+  Plotter(std::string host = "127.0.0.1", uint16_t port = 9870, Mode mode = Mode::json);
 
   ~Plotter();
 
+  // 同步发送, 调用方线程完成序列化与sendto
   void plot(const nlohmann::json & json);
 
+  // 异步遥测: 字段名只注册一次得到ID, 之后每帧 record 若干次再 commit
+  // record/commit 只写本线程的无锁缓冲区, 序列化与发送都在后台线程批量完成
+  uint16_t field(const std::string & name);
+  void record(uint16_t id, double value);
+  void commit();
+
+  // 缓冲区写满而丢弃的样本数
+  uint64_t dropped() const { return dropped_; }
+
 private:
+  struct Sample
+  {
+    uint16_t id;
+    double value;
+  };
+
+  // 单生产者(写入线程)单消费者(发送线程)环形缓冲区
+  struct Ring
+  {
+    static constexpr size_t CAPACITY = 4096;  // 必须是2的幂
+    std::array<Sample, CAPACITY> samples;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    std::vector<Sample> pending;  // 发送线程上尚未commit的样本
+  };
+
   int socket_;
   sockaddr_in destination_;
   std::mutex mutex_;
+
+  Mode mode_;
+  const uint64_t instance_id_;
+  const std::chrono::steady_clock::time_point start_;
+
+  std::mutex registry_mutex_;  // 保护 field_names_ 与 rings_
+  std::vector<std::string> field_names_;
+  std::vector<std::unique_ptr<Ring>> rings_;
+
+  std::atomic<uint64_t> dropped_;
+  std::atomic<bool> quit_;
+  std::thread sender_thread_;
+
+  Ring * local_ring();
+  void push(uint16_t id, double value);
+
+  void send_loop();
+  void serialize_frame(
+    const Sample & commit, const std::vector<Sample> & samples,
+    const std::vector<std::string> & names, std::vector<std::string> & datagrams) const;
+  void serialize_schema(
+    const std::vector<std::string> & names, std::vector<std::string> & datagrams) const;
+  void send_batch(const std::vector<std::string> & datagrams);
 };
 
 }  // namespace tools
 
-#endif  // TOOLS__PLOTTER_HPP
\ No newline at end of file
+#endif  // TOOLS__PLOTTER_HPP
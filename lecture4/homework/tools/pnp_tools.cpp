@@ -0,0 +1,36 @@
+#include "pnp_tools.hpp"
+
+namespace tools
+{
+PnPQuality evaluate_pnp(
+  const std::vector<cv::Point3f> & object_points, const std::vector<cv::Point2f> & image_points,
+  const cv::Mat & camera_matrix, const cv::Mat & dist_coeffs, const cv::Mat & rvec,
+  const cv::Mat & tvec)
+{
+  PnPQuality quality;
+  if (object_points.empty() || object_points.size() != image_points.size()) return quality;
+
+  // jacobian: 2N x (10 + 畸变参数个数), 前6列依次对应 rvec 与 tvec
+  std::vector<cv::Point2f> projected_points;
+  cv::Mat jacobian;
+  cv::projectPoints(
+    object_points, rvec, tvec, camera_matrix, dist_coeffs, projected_points, jacobian);
+
+  double sse = 0;
+  for (size_t i = 0; i < image_points.size(); i++) {
+    auto error = projected_points[i] - image_points[i];
+    sse += error.dot(error);
+  }
+  auto n = static_cast<int>(image_points.size());
+  quality.reprojection_rms = std::sqrt(sse / n);
+
+  cv::Mat J = jacobian.colRange(0, 6);
+  cv::Mat JtJ_inv;
+  cv::invert(J.t() * J, JtJ_inv, cv::DECOMP_SVD);
+  auto sigma2 = sse / std::max(2 * n - 6, 1);
+  quality.covariance = cv::Matx66d(JtJ_inv) * sigma2;
+
+  return quality;
+}
+
+}  // namespace tools
@@ -0,0 +1,24 @@
+#ifndef TOOLS__PNP_TOOLS_HPP
+#define TOOLS__PNP_TOOLS_HPP
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace tools
+{
+struct PnPQuality
+{
+  double reprojection_rms = 0;  // 单位: pixel
+  cv::Matx66d covariance;       // [rvec, tvec]的近似协方差, 单位与 rvec/tvec 一致
+};
+
+// 在 solvePnP 的解处做一次带雅可比的重投影, 给出重投影RMS与位姿协方差
+// 协方差取 sigma^2 * (J^T J)^-1, 其中 sigma^2 由残差平方和按自由度估计
+PnPQuality evaluate_pnp(
+  const std::vector<cv::Point3f> & object_points, const std::vector<cv::Point2f> & image_points,
+  const cv::Mat & camera_matrix, const cv::Mat & dist_coeffs, const cv::Mat & rvec,
+  const cv::Mat & tvec);
+
+}  // namespace tools
+
+#endif  // TOOLS__PNP_TOOLS_HPP
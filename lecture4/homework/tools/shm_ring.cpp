@@ -0,0 +1,166 @@
+#include "shm_ring.hpp"
+
+#include <fcntl.h>     // O_* constants
+#include <sys/mman.h>  // shm_open, mmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // ftruncate, close
+
+#include <cstring>
+
+#include "logger.hpp"
+
+namespace tools
+{
+ShmPublisher::ShmPublisher(
+  const std::string & name, size_t slot_count, size_t image_capacity, size_t result_capacity,
+  double max_hz)
+: name_(name),
+  period_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::duration<double>(max_hz > 0 ? 1.0 / max_hz : 0))),
+  map_(nullptr),
+  header_(nullptr)
+{
+  auto slot_size = sizeof(ShmSlotHeader) + result_capacity + image_capacity;
+  slot_size = (slot_size + 63) / 64 * 64;
+  size_ = sizeof(ShmRingHeader) + slot_count * slot_size;
+
+  auto fd = ::shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0 || ::ftruncate(fd, size_) != 0) {
+    tools::logger()->warn("ShmPublisher: unable to create {}.", name_);
+    if (fd >= 0) ::close(fd);
+    return;
+  }
+
+  auto map = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    tools::logger()->warn("ShmPublisher: unable to mmap {}.", name_);
+    return;
+  }
+
+  // 预先触碰全部页, 避免发布时缺页
+  map_ = static_cast<uint8_t *>(map);
+  std::memset(map_, 0, size_);
+
+  header_ = new (map_) ShmRingHeader;
+  header_->slot_count = slot_count;
+  header_->slot_size = slot_size;
+  header_->image_capacity = image_capacity;
+  header_->result_capacity = result_capacity;
+  header_->write_index.store(0);
+  header_->version = SHM_VERSION;
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->magic = SHM_MAGIC;  // 最后写magic, 读端看到magic即布局完整
+
+  tools::logger()->info(
+    "ShmPublisher: {} ready, {} slots x {:.1f} MB.", name_, slot_count, slot_size / 1048576.0);
+}
+
+ShmPublisher::~ShmPublisher()
+{
+  if (!map_) return;
+  ::munmap(map_, size_);
+  ::shm_unlink(name_.c_str());
+}
+
+bool ShmPublisher::publish(
+  const cv::Mat & img, std::chrono::steady_clock::time_point timestamp, const std::string & result)
+{
+  if (!ready(timestamp)) return false;
+
+  auto image_size = img.total() * img.elemSize();
+  if (image_size > header_->image_capacity) {
+    TOOLS_WARN_EVERY(
+      std::chrono::seconds(1), "ShmPublisher: image of {} bytes exceeds capacity.", image_size);
+    return false;
+  }
+  last_ = timestamp;
+
+  auto index = header_->write_index.load(std::memory_order_relaxed);
+  auto slot = map_ + sizeof(ShmRingHeader) + (index % header_->slot_count) * header_->slot_size;
+  auto slot_header = reinterpret_cast<ShmSlotHeader *>(slot);
+
+  auto seq = slot_header->seq.load(std::memory_order_relaxed);
+  slot_header->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  auto result_size = std::min(result.size(), header_->result_capacity);
+  slot_header->info = {
+    index,
+    std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count(),
+    img.cols,
+    img.rows,
+    img.type(),
+    static_cast<uint32_t>(result_size),
+    image_size};
+  std::memcpy(slot + sizeof(ShmSlotHeader), result.data(), result_size);
+
+  auto image = slot + sizeof(ShmSlotHeader) + header_->result_capacity;
+  if (img.isContinuous()) {
+    std::memcpy(image, img.data, image_size);
+  } else {
+    auto row_size = img.cols * img.elemSize();
+    for (int row = 0; row < img.rows; row++)
+      std::memcpy(image + row * row_size, img.ptr(row), row_size);
+  }
+
+  slot_header->seq.store(seq + 2, std::memory_order_release);
+  header_->write_index.store(index + 1, std::memory_order_release);
+  return true;
+}
+
+ShmSubscriber::ShmSubscriber(const std::string & name)
+: size_(0), map_(nullptr), header_(nullptr)
+{
+  auto fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) return;
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmRingHeader)) {
+    ::close(fd);
+    return;
+  }
+
+  auto map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) return;
+
+  auto header = static_cast<const ShmRingHeader *>(map);
+  auto valid = header->magic == SHM_MAGIC && header->version == SHM_VERSION;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  auto size = static_cast<size_t>(st.st_size);
+  if (valid) valid = sizeof(ShmRingHeader) + header->slot_count * header->slot_size <= size;
+  if (!valid) {
+    ::munmap(map, st.st_size);
+    return;
+  }
+
+  size_ = st.st_size;
+  map_ = static_cast<const uint8_t *>(map);
+  header_ = header;
+}
+
+ShmSubscriber::~ShmSubscriber()
+{
+  if (map_) ::munmap(const_cast<uint8_t *>(map_), size_);
+}
+
+bool ShmSubscriber::read_latest(cv::Mat & img, ShmFrameInfo & info, std::string & result) const
+{
+  bool consistent = false;
+  auto valid = view_latest([&](const ShmFrameInfo & frame, const uint8_t * image, auto text) {
+    // 被覆盖中的槽位可能给出错乱的尺寸, 先校验再分配
+    auto elem_size = CV_ELEM_SIZE(frame.type);
+    consistent = frame.width > 0 && frame.height > 0 &&
+                 uint64_t(frame.width) * frame.height * elem_size == frame.image_size;
+    if (!consistent) return;
+
+    info = frame;
+    result.assign(text);
+    img.create(frame.height, frame.width, frame.type);
+    std::memcpy(img.data, image, frame.image_size);
+  });
+  return valid && consistent;
+}
+
+}  // namespace tools
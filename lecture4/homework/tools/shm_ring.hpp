@@ -0,0 +1,124 @@
+#ifndef TOOLS__SHM_RING_HPP
+#define TOOLS__SHM_RING_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <string_view>
+
+namespace tools
+{
+// 共享内存布局: ShmRingHeader + slot_count个槽位
+// 每个槽位: ShmSlotHeader + 检测结果文本(最多 result_capacity 字节) + 图像数据
+// 写端用seqlock: 写前seq变为奇数, 写完变为偶数; 读端前后两次读到相同的偶数seq才算有效
+constexpr uint64_t SHM_MAGIC = 0x474e495257484d53;  // "SMHWRING"
+constexpr uint32_t SHM_VERSION = 1;
+
+struct ShmRingHeader
+{
+  uint64_t magic;
+  uint32_t version;
+  uint32_t slot_count;
+  uint64_t slot_size;
+  uint64_t image_capacity;
+  uint64_t result_capacity;
+  std::atomic<uint64_t> write_index;  // 已发布的帧数
+};
+
+struct ShmFrameInfo
+{
+  uint64_t frame_id;
+  int64_t timestamp_ns;  // steady_clock
+  int32_t width;
+  int32_t height;
+  int32_t type;  // cv::Mat::type()
+  uint32_t result_size;
+  uint64_t image_size;
+};
+
+struct alignas(64) ShmSlotHeader
+{
+  std::atomic<uint64_t> seq;
+  ShmFrameInfo info;
+};
+
+// 发布端: 创建共享内存并把帧与结果写入环形槽位, 从不等待读端
+class ShmPublisher
+{
+public:
+  ShmPublisher(
+    const std::string & name = "/sp_vision_frames", size_t slot_count = 4,
+    size_t image_capacity = 1440 * 1080 * 3, size_t result_capacity = 8192, double max_hz = 30);
+  ~ShmPublisher();
+
+  // 距上次发布不足 1/max_hz 时返回false, 可据此跳过结果的序列化
+  bool ready(std::chrono::steady_clock::time_point timestamp) const
+  {
+    return header_ && (last_.time_since_epoch().count() == 0 || timestamp - last_ >= period_);
+  }
+
+  // 未到发布时间的调用直接返回false, 不拷贝任何数据
+  bool publish(
+    const cv::Mat & img, std::chrono::steady_clock::time_point timestamp,
+    const std::string & result = "");
+
+private:
+  const std::string name_;
+  const std::chrono::steady_clock::duration period_;
+  std::chrono::steady_clock::time_point last_;
+  size_t size_;
+  uint8_t * map_;
+  ShmRingHeader * header_;
+};
+
+// 订阅端: 只读映射, 可在共享内存中原地访问最新一帧
+class ShmSubscriber
+{
+public:
+  explicit ShmSubscriber(const std::string & name = "/sp_vision_frames");
+  ~ShmSubscriber();
+
+  bool attached() const { return header_ != nullptr; }
+  uint64_t published() const { return header_ ? header_->write_index.load() : 0; }
+
+  // 在共享内存中原地读取最新一帧, f(info, image, result)
+  // 读取期间被写端覆盖时返回false, 此时f的结果应丢弃
+  template <typename F>
+  bool view_latest(F && f) const
+  {
+    if (!header_) return false;
+    auto index = header_->write_index.load(std::memory_order_acquire);
+    if (index == 0) return false;
+
+    auto slot_index = (index - 1) % header_->slot_count;
+    auto slot = map_ + sizeof(ShmRingHeader) + slot_index * header_->slot_size;
+    auto slot_header = reinterpret_cast<const ShmSlotHeader *>(slot);
+
+    auto seq = slot_header->seq.load(std::memory_order_acquire);
+    if (seq & 1) return false;
+
+    auto info = slot_header->info;
+    auto result = reinterpret_cast<const char *>(slot + sizeof(ShmSlotHeader));
+    auto image = slot + sizeof(ShmSlotHeader) + header_->result_capacity;
+    if (info.result_size > header_->result_capacity || info.image_size > header_->image_capacity)
+      return false;
+    f(info, image, std::string_view(result, info.result_size));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot_header->seq.load(std::memory_order_relaxed) == seq;
+  }
+
+  // 拷贝出最新一帧
+  bool read_latest(cv::Mat & img, ShmFrameInfo & info, std::string & result) const;
+
+private:
+  size_t size_;
+  const uint8_t * map_;
+  const ShmRingHeader * header_;
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__SHM_RING_HPP
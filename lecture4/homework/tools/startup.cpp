@@ -0,0 +1,45 @@
+#include "startup.hpp"
+
+#include "logger.hpp"
+
+namespace tools
+{
+Startup::Startup() : start_(std::chrono::steady_clock::now()) {}
+
+void Startup::mark(const std::string & event)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto & [name, ms] : events_)
+    if (name == event) return;
+
+  auto ms = since_start(std::chrono::steady_clock::now());
+  events_.emplace_back(event, ms);
+  tools::logger()->info("Startup: {} at {:.0f} ms", event, ms);
+}
+
+void Startup::report() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto & task : tasks_)
+    tools::logger()->info(
+      "Startup task {:<10} {:>6.0f} -> {:>6.0f} ms ({:.0f} ms)", task.name, task.begin_ms,
+      task.end_ms, task.end_ms - task.begin_ms);
+  for (const auto & [event, ms] : events_)
+    tools::logger()->info("Startup event {:<14} {:>6.0f} ms", event, ms);
+}
+
+double Startup::since_start(std::chrono::steady_clock::time_point time) const
+{
+  return std::chrono::duration<double, std::milli>(time - start_).count();
+}
+
+void Startup::finish(const std::string & name, std::chrono::steady_clock::time_point begin)
+{
+  auto end = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  tasks_.push_back({name, since_start(begin), since_start(end)});
+  tools::logger()->info(
+    "Startup: {} ready in {:.0f} ms", name, since_start(end) - since_start(begin));
+}
+
+}  // namespace tools
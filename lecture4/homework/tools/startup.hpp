@@ -0,0 +1,57 @@
+#ifndef TOOLS__STARTUP_HPP
+#define TOOLS__STARTUP_HPP
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tools
+{
+// 启动编排: 相机、模型编译、标定加载等相互独立的初始化并行执行, 并记录启动时间线
+// 时间均相对于 Startup 构造时刻(应在 main 开头构造)
+class Startup
+{
+public:
+  Startup();
+
+  // 在独立线程上执行初始化任务, 通过返回的 future 取得结果; 任务抛出的异常在 get() 时重新抛出
+  template <typename F>
+  auto launch(const std::string & name, F f)
+  {
+    return std::async(std::launch::async, [this, name, f = std::move(f)]() mutable {
+      auto begin = std::chrono::steady_clock::now();
+      auto result = f();
+      finish(name, begin);
+      return result;
+    });
+  }
+
+  // 记录里程碑(如首帧、首个结果), 同名事件只记录第一次, 可在任意线程调用
+  // 每次调用都加锁并查找已有事件, 每帧经过的调用点应在外面用 std::call_once 等只调用一次
+  void mark(const std::string & event);
+
+  // 输出各初始化任务的起止时间与各里程碑时刻
+  void report() const;
+
+private:
+  struct Entry
+  {
+    std::string name;
+    double begin_ms, end_ms;
+  };
+
+  const std::chrono::steady_clock::time_point start_;
+  mutable std::mutex mutex_;
+  std::vector<Entry> tasks_;
+  std::vector<std::pair<std::string, double>> events_;
+
+  double since_start(std::chrono::steady_clock::time_point time) const;
+  void finish(const std::string & name, std::chrono::steady_clock::time_point begin);
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__STARTUP_HPP
@@ -0,0 +1,243 @@
+#include "thread_config.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <opencv2/core.hpp>
+#include <sstream>
+
+#include "logger.hpp"
+
+namespace tools
+{
+namespace
+{
+std::mutex config_mutex;
+std::map<std::string, ThreadPolicy> policies;
+InferenceConfig inference;
+
+std::mutex jitter_mutex;
+std::map<std::string, std::unique_ptr<JitterMeter>> jitter_meters;
+
+std::vector<int> read_cpus(const cv::FileNode & node)
+{
+  std::vector<int> cpus;
+  if (node.isSeq())
+    for (const auto & cpu : node) cpus.push_back(static_cast<int>(cpu));
+  else if (node.isInt())
+    cpus.push_back(static_cast<int>(node));
+  return cpus;
+}
+
+// 解析内核的核心列表格式, 例如 "2-3,5"
+std::vector<int> parse_cpu_list(const std::string & text)
+{
+  std::vector<int> cpus;
+  std::stringstream ss(text);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (item.empty() || item == "\n") continue;
+    auto dash = item.find('-');
+    try {
+      auto first = std::stoi(item.substr(0, dash));
+      auto last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+      for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    } catch (const std::exception &) {
+    }
+  }
+  return cpus;
+}
+
+// 内核启动参数 isolcpus= 隔离出的核心, 不会被调度器放入普通任务
+std::vector<int> isolated_cpus()
+{
+  std::ifstream file("/sys/devices/system/cpu/isolated");
+  std::string text;
+  std::getline(file, text);
+  return parse_cpu_list(text);
+}
+
+std::string to_string(const std::vector<int> & cpus)
+{
+  std::string text;
+  for (auto cpu : cpus) text += (text.empty() ? "" : ",") + std::to_string(cpu);
+  return text.empty() ? "all" : text;
+}
+
+bool set_affinity(const std::vector<int> & cpus)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus)
+    if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+  return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+}
+
+}  // namespace
+
+bool load_thread_config(const std::string & path)
+{
+  cv::FileStorage fs;
+  try {
+    fs.open(path, cv::FileStorage::READ);
+  } catch (const cv::Exception & e) {
+    tools::logger()->warn("Failed to parse thread config {}: {}", path, e.what());
+    return false;
+  }
+  if (!fs.isOpened()) {
+    tools::logger()->warn("Thread config {} not found, using default scheduling.", path);
+    return false;
+  }
+
+  std::map<std::string, ThreadPolicy> loaded;
+  InferenceConfig loaded_inference;
+  for (const auto & node : fs.root()) {
+    if (!node.isMap()) continue;
+    if (node.name() == "inference") {
+      loaded_inference.cpus = read_cpus(node["cpus"]);
+      if (!node["threads"].empty()) loaded_inference.threads = static_cast<int>(node["threads"]);
+      continue;
+    }
+    ThreadPolicy policy;
+    policy.cpus = read_cpus(node["cpus"]);
+    if (!node["priority"].empty()) policy.priority = static_cast<int>(node["priority"]);
+    loaded[node.name()] = policy;
+  }
+
+  // 实时线程最好独占 isolcpus 隔离出的核心, 否则仍会被普通任务和中断打断
+  auto isolated = isolated_cpus();
+  for (const auto & [role, policy] : loaded) {
+    tools::logger()->info(
+      "Thread \"{}\": cpus {}, priority {}", role, to_string(policy.cpus), policy.priority);
+    if (policy.priority <= 0) continue;
+    for (auto cpu : policy.cpus)
+      if (std::find(isolated.begin(), isolated.end(), cpu) == isolated.end())
+        tools::logger()->warn(
+          "Real-time thread \"{}\" uses cpu {} which is not isolated (isolated: {})", role, cpu,
+          isolated.empty() ? "none" : to_string(isolated));
+  }
+  tools::logger()->info(
+    "Inference: cpus {}, threads {}", to_string(loaded_inference.cpus), loaded_inference.threads);
+
+  std::lock_guard<std::mutex> lock(config_mutex);
+  policies = std::move(loaded);
+  inference = loaded_inference;
+  return true;
+}
+
+std::optional<ThreadPolicy> thread_policy(const std::string & role)
+{
+  std::lock_guard<std::mutex> lock(config_mutex);
+  auto it = policies.find(role);
+  if (it == policies.end()) return std::nullopt;
+  return it->second;
+}
+
+InferenceConfig inference_config()
+{
+  std::lock_guard<std::mutex> lock(config_mutex);
+  return inference;
+}
+
+void apply_thread_policy(const std::string & role)
+{
+  // 线程名最长15个字符, 便于在 top -H / perf 中区分
+  ::pthread_setname_np(::pthread_self(), role.substr(0, 15).c_str());
+
+  auto policy = thread_policy(role);
+  if (!policy) return;
+
+  if (!policy->cpus.empty() && !set_affinity(policy->cpus))
+    tools::logger()->warn("Failed to pin thread \"{}\" to cpus {}", role, to_string(policy->cpus));
+
+  if (policy->priority > 0) {
+    sched_param param{};
+    param.sched_priority = std::clamp(
+      policy->priority, ::sched_get_priority_min(SCHED_FIFO), ::sched_get_priority_max(SCHED_FIFO));
+    auto ret = ::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &param);
+    if (ret != 0)
+      tools::logger()->warn(
+        "Failed to set SCHED_FIFO {} for thread \"{}\": {}", param.sched_priority, role,
+        std::strerror(ret));
+  }
+}
+
+ScopedAffinity::ScopedAffinity(const std::vector<int> & cpus) : restore_(false)
+{
+  if (cpus.empty()) return;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (::pthread_getaffinity_np(::pthread_self(), sizeof(set), &set) != 0) return;
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    if (CPU_ISSET(cpu, &set)) saved_.push_back(cpu);
+
+  restore_ = set_affinity(cpus);
+  if (!restore_) tools::logger()->warn("Failed to set affinity to cpus {}", to_string(cpus));
+}
+
+ScopedAffinity::~ScopedAffinity()
+{
+  if (restore_) set_affinity(saved_);
+}
+
+JitterMeter::JitterMeter(const std::string & name)
+: name_(name), periods_ns_(CAPACITY, 0), count_(0), last_ns_(0)
+{
+}
+
+void JitterMeter::tick()
+{
+  auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+               .count();
+  if (last_ns_ != 0) {
+    auto count = count_.load(std::memory_order_relaxed);
+    periods_ns_[count % CAPACITY] = now - last_ns_;
+    count_.store(count + 1, std::memory_order_release);
+  }
+  last_ns_ = now;
+}
+
+void JitterMeter::report() const
+{
+  auto count = std::min<uint64_t>(count_.load(std::memory_order_acquire), CAPACITY);
+  if (count == 0) return;
+
+  std::vector<int64_t> periods(periods_ns_.begin(), periods_ns_.begin() + count);
+  std::sort(periods.begin(), periods.end());
+
+  double mean = 0, variance = 0;
+  for (auto period : periods) mean += period;
+  mean /= count;
+  for (auto period : periods) variance += (period - mean) * (period - mean);
+  variance /= count;
+
+  tools::logger()->info(
+    "[{}] period mean {:.3f} ms, std {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms ({} samples)", name_,
+    mean / 1e6, std::sqrt(variance) / 1e6, periods[(count - 1) * 99 / 100] / 1e6,
+    periods.back() / 1e6, count);
+}
+
+JitterMeter & jitter_meter(const std::string & name)
+{
+  std::lock_guard<std::mutex> lock(jitter_mutex);
+  auto & meter = jitter_meters[name];
+  if (!meter) meter = std::make_unique<JitterMeter>(name);
+  return *meter;
+}
+
+void report_jitter()
+{
+  std::lock_guard<std::mutex> lock(jitter_mutex);
+  for (const auto & [name, meter] : jitter_meters) meter->report();
+}
+
+}  // namespace tools
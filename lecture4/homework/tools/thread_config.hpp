@@ -0,0 +1,81 @@
+#ifndef TOOLS__THREAD_CONFIG_HPP
+#define TOOLS__THREAD_CONFIG_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tools
+{
+// 单个线程角色的调度配置
+// cpus 为空时不绑核; priority > 0 时使用 SCHED_FIFO(需 CAP_SYS_NICE 或 rtprio 限额)
+struct ThreadPolicy
+{
+  std::vector<int> cpus;
+  int priority = 0;
+};
+
+// OpenVINO CPU 推理: threads 为 0 时由插件自行决定, cpus 为推理线程池可用的核心
+struct InferenceConfig
+{
+  std::vector<int> cpus;
+  int threads = 0;
+};
+
+// 从 YAML 读取所有线程角色的配置, 文件不存在时保持默认调度
+// 需在创建相机、模型和流水线之前调用
+bool load_thread_config(const std::string & path);
+
+std::optional<ThreadPolicy> thread_policy(const std::string & role);
+
+InferenceConfig inference_config();
+
+// 在线程入口处调用: 设置线程名, 并按 role 的配置绑核、设置实时优先级
+// 没有该角色的配置时只设置线程名
+void apply_thread_policy(const std::string & role);
+
+// 在作用域内把当前线程临时绑定到 cpus, 析构时恢复
+// 用于让 OpenVINO 等在构造时读取亲和性的库只使用给定核心
+class ScopedAffinity
+{
+public:
+  explicit ScopedAffinity(const std::vector<int> & cpus);
+  ~ScopedAffinity();
+
+private:
+  bool restore_;
+  std::vector<int> saved_;
+};
+
+// 周期抖动统计: 周期性线程每轮调用 tick(), 只允许单个线程写入
+class JitterMeter
+{
+public:
+  explicit JitterMeter(const std::string & name);
+
+  void tick();
+
+  // 输出周期的均值、标准差、p99 与最大值
+  void report() const;
+
+private:
+  static constexpr size_t CAPACITY = 8192;
+
+  const std::string name_;
+  std::vector<int64_t> periods_ns_;  // 最近 CAPACITY 个周期
+  std::atomic<uint64_t> count_;
+  int64_t last_ns_;
+};
+
+// 按名字取得全局的抖动统计, 首次调用时创建; 返回的引用在进程内一直有效
+JitterMeter & jitter_meter(const std::string & name);
+
+// 输出所有抖动统计, 应在各线程结束后调用
+void report_jitter();
+
+}  // namespace tools
+
+#endif  // TOOLS__THREAD_CONFIG_HPP
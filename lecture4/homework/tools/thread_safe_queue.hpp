@@ -1,6 +1,7 @@
 #ifndef TOOLS__THREAD_SAFE_QUEUE_HPP
 #define TOOLS__THREAD_SAFE_QUEUE_HPP
 
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <iostream>
@@ -51,6 +52,20 @@ public:
     queue_.pop();
   }
 
+  // 最多等待 timeout, 超时返回false
+  template <typename Rep, typename Period>
+  bool pop_for(T & value, const std::chrono::duration<Rep, Period> & timeout)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (!not_empty_condition_.wait_for(lock, timeout, [this] { return !queue_.empty(); }))
+      return false;
+
+    value = queue_.front();
+    queue_.pop();
+    return true;
+  }
+
   T pop()
   {
     std::unique_lock<std::mutex> lock(mutex_);
@@ -0,0 +1,126 @@
+#include "video_source.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace tools
+{
+// 按帧号跳转并确认解码位置: 很多编码格式只能跳到关键帧, 落在目标之前时向后解码到目标帧
+// 后端报告的位置与目标不一致(越过目标或不支持查询)时返回false
+static bool seek_exact(cv::VideoCapture & cap, int64_t frame)
+{
+  if (!cap.set(cv::CAP_PROP_POS_FRAMES, frame)) return false;
+  auto position = static_cast<int64_t>(cap.get(cv::CAP_PROP_POS_FRAMES));
+  for (auto skip = frame - position; skip > 0 && position < frame && cap.grab(); skip--)
+    position = static_cast<int64_t>(cap.get(cv::CAP_PROP_POS_FRAMES));
+  return position == frame;
+}
+
+VideoSource::VideoSource(const std::string & path, int workers, size_t buffer_size, int chunk)
+: path_(path),
+  buffer_size_(std::max<size_t>(buffer_size, chunk)),
+  chunk_(std::max(1, chunk)),
+  opened_(false),
+  next_(0),
+  end_(std::numeric_limits<int64_t>::max()),
+  running_(0),
+  next_chunk_(0),
+  sequential_(false),
+  quit_(false)
+{
+  cv::VideoCapture cap(path_);
+  opened_ = cap.isOpened();
+  if (!opened_) return;
+
+  // 总帧数未知(如网络流)时无法按块跳转, 退化为单线程顺序解码
+  auto frame_count = static_cast<int64_t>(cap.get(cv::CAP_PROP_FRAME_COUNT));
+  auto seekable = frame_count > 0;
+  if (seekable) end_ = frame_count;
+
+  if (workers <= 0) workers = std::max(1u, std::thread::hardware_concurrency());
+  if (!seekable) workers = 1;
+
+  running_ = workers;
+  for (int i = 0; i < workers; i++) workers_.emplace_back([this, seekable] { work(seekable); });
+}
+
+VideoSource::~VideoSource()
+{
+  quit_ = true;
+  space_.notify_all();
+  for (auto & worker : workers_) worker.join();
+}
+
+bool VideoSource::read(cv::Mat & img)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  ready_.wait(lock, [this] { return buffer_.count(next_) || next_ >= end_ || running_ == 0; });
+
+  auto it = buffer_.find(next_);
+  if (it == buffer_.end()) return false;
+
+  img = std::move(it->second);
+  buffer_.erase(it);
+  next_++;
+  space_.notify_all();
+  return true;
+}
+
+void VideoSource::work(bool seekable)
+{
+  cv::VideoCapture cap(path_);
+  int64_t position = 0;  // cap下一次read得到的帧序号
+
+  while (!quit_) {
+    // 已有线程退化为顺序解码时不再领取新块
+    if (seekable && sequential_) break;
+    auto begin = seekable ? next_chunk_.fetch_add(1) * chunk_ : position;
+    auto end = seekable ? begin + chunk_ : std::numeric_limits<int64_t>::max();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (begin >= end_) break;
+    }
+
+    // 跳转无法精确到帧时, 本线程从头顺序解码到 begin, 之后一直顺序解码到结尾
+    // 保证与单线程顺序解码的输出一致; 其余线程做完已领取的块后退出
+    if (position != begin && !seek_exact(cap, begin)) {
+      sequential_ = true;
+      seekable = false;
+      end = std::numeric_limits<int64_t>::max();
+      cap.open(path_);
+      for (position = 0; position < begin && !quit_ && cap.grab(); position++) {
+      }
+      if (position < begin) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        end_ = std::min(end_, position);
+        ready_.notify_all();
+        break;
+      }
+    }
+    position = begin;
+
+    for (; position < end && !quit_; position++) {
+      cv::Mat img;
+      if (!cap.read(img) || img.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        end_ = std::min(end_, position);
+        ready_.notify_all();
+        break;
+      }
+
+      // 超前太多时等待消费者, 持有 next_ 所在块的线程总能继续
+      std::unique_lock<std::mutex> lock(mutex_);
+      space_.wait(lock, [&] { return quit_ || position < next_ + int64_t(buffer_size_); });
+      if (quit_ || position >= end_) break;
+      // 顺序解码的线程可能与其他线程的块重叠, 已输出或已存在的帧直接丢弃
+      if (position >= next_) buffer_.emplace(position, std::move(img));
+      ready_.notify_all();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_--;
+  ready_.notify_all();
+}
+
+}  // namespace tools
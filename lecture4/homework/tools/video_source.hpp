@@ -0,0 +1,55 @@
+#ifndef TOOLS__VIDEO_SOURCE_HPP
+#define TOOLS__VIDEO_SOURCE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tools
+{
+// 多线程预解码的视频源
+// 视频按 chunk 帧切块, 每个工作线程持有独立的 VideoCapture, 轮流领取块并跳转解码
+// 跳转后确认解码位置, 无法精确到帧时退化为单线程顺序解码, 输出与顺序解码一致
+// 解码结果放入有界的重排缓冲区, read 按原始顺序取出
+class VideoSource
+{
+public:
+  // workers 为0时取CPU核数, buffer_size 至少为 chunk
+  explicit VideoSource(
+    const std::string & path, int workers = 0, size_t buffer_size = 64, int chunk = 32);
+  ~VideoSource();
+
+  bool isOpened() const { return opened_; }
+
+  // 视频结尾或读取失败时返回false
+  bool read(cv::Mat & img);
+
+private:
+  const std::string path_;
+  const size_t buffer_size_;
+  const int chunk_;
+  bool opened_;
+
+  std::map<int64_t, cv::Mat> buffer_;  // 帧序号 -> 图像
+  int64_t next_;                       // 下一个要输出的帧序号
+  int64_t end_;                        // 已知的总帧数, 解码失败时缩小
+  int running_;                        // 仍在工作的线程数
+  std::mutex mutex_;
+  std::condition_variable ready_, space_;
+
+  std::atomic<int64_t> next_chunk_;
+  std::atomic<bool> sequential_;  // 跳转不精确, 已退化为单线程顺序解码
+  std::atomic<bool> quit_;
+  std::vector<std::thread> workers_;
+
+  void work(bool seekable);
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__VIDEO_SOURCE_HPP
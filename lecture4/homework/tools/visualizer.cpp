@@ -0,0 +1,98 @@
+#include "visualizer.hpp"
+
+#include <sys/resource.h>  // setpriority
+#include <sys/syscall.h>   // SYS_gettid
+#include <unistd.h>        // syscall
+
+#include "logger.hpp"
+#include "thread_config.hpp"
+
+namespace tools
+{
+Visualizer::Visualizer(const std::string & window, double max_hz, double scale)
+: window_(window),
+  period_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::duration<double>(1.0 / max_hz))),
+  scale_(scale),
+  pending_(false),
+  key_(-1),
+  dropped_(0),
+  quit_(false)
+{
+  render_thread_ = std::thread{[this] { render_loop(); }};
+}
+
+Visualizer::~Visualizer()
+{
+  quit_ = true;
+  condition_.notify_one();
+  if (render_thread_.joinable()) render_thread_.join();
+  tools::logger()->info("Visualizer stopped, {} frames dropped.", dropped_);
+}
+
+void Visualizer::submit(const cv::Mat & frame, Draw draw)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (pending_) dropped_++;
+  frame_ = frame;
+  draw_ = std::move(draw);
+  pending_ = true;
+  condition_.notify_one();
+}
+
+void Visualizer::render_loop()
+{
+  // 只调低本线程的优先级, 与检测线程争抢CPU时让步
+  ::setpriority(PRIO_PROCESS, ::syscall(SYS_gettid), 10);
+  tools::apply_thread_policy("render");
+
+  auto next = std::chrono::steady_clock::now();
+  cv::Mat shown;  // 最近一次显示的图像, 供's'键保存
+
+  while (!quit_) {
+    cv::Mat frame, img;
+    Draw draw;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait_for(lock, period_, [this] { return quit_ || pending_; });
+      if (quit_) break;
+      if (pending_) {
+        frame = std::move(frame_);
+        draw = std::move(draw_);
+        frame_ = cv::Mat();
+        pending_ = false;
+      }
+    }
+
+    // 在锁外拷贝, submit 不会等待整幅图像的拷贝; frame 持有引用, 缓冲池不会复用这块内存
+    if (!frame.empty()) {
+      img = frame.clone();
+      frame.release();
+      if (draw) draw(img);
+      if (scale_ != 1.0) cv::resize(img, img, {}, scale_, scale_);
+      cv::imshow(window_, img);
+      shown = img;
+    }
+
+    // 即使没有新帧也要处理窗口事件
+    auto key = cv::waitKey(1);
+    if (key == 's' || key == 'S') {
+      auto filename = fmt::format(
+        "capture_{}.jpg", std::chrono::system_clock::now().time_since_epoch().count());
+      if (!shown.empty() && cv::imwrite(filename, shown))
+        tools::logger()->info("Image saved: {}", filename);
+    } else if (key >= 0) {
+      key_ = key;
+    }
+
+    // 限制渲染帧率
+    next += period_;
+    auto now = std::chrono::steady_clock::now();
+    if (next < now) next = now;
+    std::this_thread::sleep_until(next);
+  }
+
+  cv::destroyWindow(window_);
+}
+
+}  // namespace tools
@@ -0,0 +1,56 @@
+#ifndef TOOLS__VISUALIZER_HPP
+#define TOOLS__VISUALIZER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+
+namespace tools
+{
+// 低优先级渲染线程: 绘制、imshow、waitKey 全部在此线程完成, 不占用检测循环
+class Visualizer
+{
+public:
+  using Draw = std::function<void(cv::Mat &)>;
+
+  explicit Visualizer(
+    const std::string & window = "Detection Results", double max_hz = 30, double scale = 0.8);
+  ~Visualizer();
+
+  // 提交一帧快照, draw 在渲染线程上对图像副本绘制
+  // frame 只做浅拷贝, 提交后调用方不应再修改它
+  // 渲染线程忙时直接覆盖未渲染的快照(丢帧), 调用方从不等待
+  void submit(const cv::Mat & frame, Draw draw);
+
+  // 窗口中最近一次按键, 读取后清除, 无按键返回-1
+  int key() { return key_.exchange(-1); }
+
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  const std::string window_;
+  const std::chrono::steady_clock::duration period_;
+  const double scale_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  cv::Mat frame_;
+  Draw draw_;
+  bool pending_;
+
+  std::atomic<int> key_;
+  std::atomic<uint64_t> dropped_;
+  std::atomic<bool> quit_;
+  std::thread render_thread_;
+
+  void render_loop();
+};
+
+}  // namespace tools
+
+#endif  // TOOLS__VISUALIZER_HPP